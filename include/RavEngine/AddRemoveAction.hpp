@@ -8,4 +8,19 @@ namespace RavEngine{
         }
         inline void DoAction(T* ptr){}
     };
+
+    template <typename T>
+    class HasDestroy
+    {
+    private:
+        typedef char YesType[1];
+        typedef char NoType[2];
+
+        template <typename C> static YesType& test( decltype(&C::Destroy) ) ;
+        template <typename C> static NoType& test(...);
+
+
+    public:
+        enum { value = sizeof(test<T>(0)) == sizeof(YesType) };
+    };
 }
@@ -315,7 +315,7 @@ protected:
 	ozz::vector<ozz::math::Float4x4> models;
     mutable ozz::vector<matrix4> glm_pose;
 	ozz::vector<matrix4> local_pose;
-	ozz::vector<matrix4> skinningmats;
+	ozz::vector<InstanceTransform> skinningmats;		// in the layout the GPU reads, so extraction and upload only copy
 	
 	/**
 	 Update buffer sizes for current skeleton
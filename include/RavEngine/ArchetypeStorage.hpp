@@ -0,0 +1,428 @@
+#pragma once
+#include "Types.hpp"
+#include "CTTI.hpp"
+#include "DataStructures.hpp"
+#include "AddRemoveAction.hpp"
+#include <new>
+#include <memory>
+#include <tuple>
+#include <algorithm>
+#include <cassert>
+
+namespace RavEngine{
+
+/**
+ Derive a component from this type to store it in archetype chunks instead of a SparseSet.
+ Entities with the same set of chunked components are packed together, so Filters and Systems
+ that request only chunked types iterate memory linearly rather than looking up every type per entity.
+ @note Chunked components are relocated when their owner gains or loses a chunked component, so do not hold references to them across those calls. They cannot be Queryable.
+ */
+struct ChunkedComponent : public AutoCTTI{};
+
+template<typename T>
+static constexpr bool IsChunked = std::is_base_of<ChunkedComponent, T>::value;
+
+/**
+ Stores components grouped by signature (the set of component types an entity has) in fixed-size
+ structure-of-arrays chunks. Adding or removing a component moves the entity's row to the archetype
+ for its new signature, and removals swap the last row of the archetype into the hole.
+ */
+class ArchetypeStorage{
+public:
+    constexpr static size_t chunk_bytes = 16 * 1024;
+    constexpr static size_t chunk_alignment = 64;
+
+    struct ColumnInfo{
+        ctti_t id;
+        uint32_t size;
+        uint32_t alignment;
+        void(*relocate)(void* dest, void* src);   // move-construct dest from src, then destruct src
+        void(*destruct)(void* ptr);
+        void(*remove)(void* ptr);                 // run the type's remove hooks, then destruct
+
+        template<typename T>
+        static const ColumnInfo* For(){
+            static_assert(alignof(T) <= chunk_alignment, "Component alignment is too large to be chunked");
+            static const ColumnInfo info{
+                CTTI<T>(),
+                static_cast<uint32_t>(sizeof(T)),
+                static_cast<uint32_t>(alignof(T)),
+                [](void* dest, void* src){
+                    auto srcT = static_cast<T*>(src);
+                    new (dest) T(std::move(*srcT));
+                    srcT->~T();
+                },
+                [](void* ptr){
+                    static_cast<T*>(ptr)->~T();
+                },
+                [](void* ptr){
+                    auto comp = static_cast<T*>(ptr);
+                    if constexpr (RemoveAction<T>::HasCustomAction()){
+                        RemoveAction<T> obj;
+                        obj.DoAction(comp);
+                    }
+                    if constexpr (HasDestroy<T>::value){
+                        comp->Destroy();
+                    }
+                    comp->~T();
+                }
+            };
+            return &info;
+        }
+    };
+
+    // identifies one chunk of one archetype, for dividing work between threads
+    struct ChunkRef{
+        uint32_t archetype;
+        uint32_t chunk;
+    };
+
+private:
+    struct Chunk{
+        struct Deleter{
+            void operator()(std::byte* ptr) const{
+                ::operator delete(ptr, std::align_val_t{chunk_alignment});
+            }
+        };
+        std::unique_ptr<std::byte[], Deleter> memory;
+        uint32_t count = 0;
+    };
+
+    struct Archetype{
+        Vector<const ColumnInfo*> columns;      // sorted by id
+        Vector<size_t> offsets;                 // byte offset of each column's array within a chunk
+        size_t bytesPerChunk = 0;
+        uint32_t capacity = 0;                  // rows per chunk
+        Vector<Chunk> chunks;
+        UnorderedMap<ctti_t, uint32_t> addEdges, removeEdges;
+
+        inline int ColumnIndex(ctti_t id) const{
+            auto it = std::lower_bound(columns.begin(), columns.end(), id, [](const ColumnInfo* col, ctti_t id){
+                return col->id < id;
+            });
+            return (it != columns.end() && (*it)->id == id) ? static_cast<int>(std::distance(columns.begin(), it)) : -1;
+        }
+
+        template<typename ... A>
+        inline bool HasAll() const{
+            return ((ColumnIndex(CTTI<A>()) >= 0) && ...);
+        }
+
+        inline entity_t* Entities(const Chunk& chunk) const{
+            return reinterpret_cast<entity_t*>(chunk.memory.get());
+        }
+
+        inline void* ColumnBase(const Chunk& chunk, uint32_t column) const{
+            return chunk.memory.get() + offsets[column];
+        }
+
+        inline void* At(const Chunk& chunk, uint32_t column, uint32_t row) const{
+            return chunk.memory.get() + offsets[column] + size_t(row) * columns[column]->size;
+        }
+    };
+
+    struct Location{
+        uint32_t archetype = INVALID_INDEX;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+    };
+
+    Vector<Archetype> archetypes;
+    Vector<Location> locations;     // indexed by local entity id
+
+    static inline size_t AlignUp(size_t value, size_t alignment){
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    uint32_t FindOrCreate(const Vector<const ColumnInfo*>& columns){
+        for(uint32_t i = 0; i < archetypes.size(); i++){
+            const auto& other = archetypes[i].columns;
+            if (other.size() == columns.size() && std::equal(other.begin(), other.end(), columns.begin(), [](auto a, auto b){
+                return a->id == b->id;
+            })){
+                return i;
+            }
+        }
+
+        Archetype arch;
+        arch.columns = columns;
+
+        // fit as many rows as possible into a chunk, leaving room to align each column
+        size_t rowBytes = sizeof(entity_t);
+        for(const auto col : columns){
+            rowBytes += col->size;
+        }
+        const size_t padding = columns.size() * chunk_alignment;
+        arch.capacity = static_cast<uint32_t>(std::max<size_t>(1, (chunk_bytes - std::min(padding, chunk_bytes)) / rowBytes));
+
+        size_t offset = arch.capacity * sizeof(entity_t);
+        for(const auto col : columns){
+            offset = AlignUp(offset, col->alignment);
+            arch.offsets.push_back(offset);
+            offset += size_t(arch.capacity) * col->size;
+        }
+        arch.bytesPerChunk = offset;
+
+        archetypes.push_back(std::move(arch));
+        return static_cast<uint32_t>(archetypes.size() - 1);
+    }
+
+    uint32_t ArchetypeWith(uint32_t src, const ColumnInfo* added){
+        if (src == INVALID_INDEX){
+            return FindOrCreate({added});
+        }
+        auto it = archetypes[src].addEdges.find(added->id);
+        if (it != archetypes[src].addEdges.end()){
+            return it->second;
+        }
+        auto columns = archetypes[src].columns;
+        columns.insert(std::upper_bound(columns.begin(), columns.end(), added, [](auto a, auto b){
+            return a->id < b->id;
+        }), added);
+        auto dest = FindOrCreate(columns);
+        archetypes[src].addEdges[added->id] = dest;     // FindOrCreate may have reallocated, so index again
+        return dest;
+    }
+
+    uint32_t ArchetypeWithout(uint32_t src, ctti_t removed){
+        auto it = archetypes[src].removeEdges.find(removed);
+        if (it != archetypes[src].removeEdges.end()){
+            return it->second;
+        }
+        auto columns = archetypes[src].columns;
+        columns.erase(std::remove_if(columns.begin(), columns.end(), [removed](auto col){
+            return col->id == removed;
+        }), columns.end());
+        auto dest = columns.empty() ? INVALID_INDEX : FindOrCreate(columns);
+        archetypes[src].removeEdges[removed] = dest;
+        return dest;
+    }
+
+    Location AllocateRow(uint32_t a, entity_t local_id){
+        auto& arch = archetypes[a];
+        if (arch.chunks.empty() || arch.chunks.back().count == arch.capacity){
+            arch.chunks.emplace_back();
+            arch.chunks.back().memory.reset(static_cast<std::byte*>(::operator new(arch.bytesPerChunk, std::align_val_t{chunk_alignment})));
+        }
+        auto& chunk = arch.chunks.back();
+        Location loc{a, static_cast<uint32_t>(arch.chunks.size() - 1), chunk.count++};
+        arch.Entities(chunk)[loc.row] = local_id;
+        return loc;
+    }
+
+    // fill a row whose components have already been relocated or destroyed
+    void CompactRow(const Location& loc){
+        auto& arch = archetypes[loc.archetype];
+        auto& chunk = arch.chunks[loc.chunk];
+        auto& lastChunk = arch.chunks.back();
+        const uint32_t lastRow = lastChunk.count - 1;
+        if (&chunk != &lastChunk || loc.row != lastRow){
+            for(uint32_t c = 0; c < arch.columns.size(); c++){
+                arch.columns[c]->relocate(arch.At(chunk, c, loc.row), arch.At(lastChunk, c, lastRow));
+            }
+            auto moved = arch.Entities(lastChunk)[lastRow];
+            arch.Entities(chunk)[loc.row] = moved;
+            locations[moved].chunk = loc.chunk;
+            locations[moved].row = loc.row;
+        }
+        lastChunk.count--;
+        if (lastChunk.count == 0){
+            arch.chunks.pop_back();
+        }
+    }
+
+    // move an entity's row into another archetype of this storage, removing columns the destination lacks
+    Location MoveRow(entity_t local_id, uint32_t dest){
+        const auto src = locations[local_id];
+        Location newloc;
+        if (dest != INVALID_INDEX){
+            newloc = AllocateRow(dest, local_id);
+        }
+        auto& srcArch = archetypes[src.archetype];
+        auto& srcChunk = srcArch.chunks[src.chunk];
+        for(uint32_t c = 0; c < srcArch.columns.size(); c++){
+            auto ptr = srcArch.At(srcChunk, c, src.row);
+            auto destCol = dest != INVALID_INDEX ? archetypes[dest].ColumnIndex(srcArch.columns[c]->id) : -1;
+            if (destCol >= 0){
+                auto& destArch = archetypes[dest];
+                srcArch.columns[c]->relocate(destArch.At(destArch.chunks[newloc.chunk], destCol, newloc.row), ptr);
+            }
+            else{
+                srcArch.columns[c]->remove(ptr);
+            }
+        }
+        CompactRow(src);
+        locations[local_id] = newloc;
+        return newloc;
+    }
+
+    inline bool HasAny(entity_t local_id) const{
+        return local_id < locations.size() && locations[local_id].archetype != INVALID_INDEX;
+    }
+
+public:
+    ArchetypeStorage(){}
+    ArchetypeStorage(const ArchetypeStorage&) = delete;
+
+    ~ArchetypeStorage(){
+        for(auto& arch : archetypes){
+            for(auto& chunk : arch.chunks){
+                for(uint32_t c = 0; c < arch.columns.size(); c++){
+                    for(uint32_t row = 0; row < chunk.count; row++){
+                        arch.columns[c]->destruct(arch.At(chunk, c, row));
+                    }
+                }
+            }
+        }
+    }
+
+    template<typename T, typename ... A>
+    inline T& Emplace(entity_t local_id, A&& ... args){
+        if (local_id >= locations.size()){
+            locations.resize(std::max<size_t>(local_id + 1, locations.size() * 2));
+        }
+        assert(!Has<T>(local_id));  // an entity cannot have two of the same chunked component
+        const auto info = ColumnInfo::template For<T>();
+        const auto src = locations[local_id].archetype;
+        const auto dest = ArchetypeWith(src, info);
+
+        Location loc;
+        if (src == INVALID_INDEX){
+            loc = AllocateRow(dest, local_id);
+            locations[local_id] = loc;
+        }
+        else{
+            loc = MoveRow(local_id, dest);
+        }
+        auto& arch = archetypes[dest];
+        auto ptr = arch.At(arch.chunks[loc.chunk], arch.ColumnIndex(info->id), loc.row);
+        return *(new (ptr) T(std::forward<A>(args)...));
+    }
+
+    /**
+     Destroy a component, running its remove hooks
+     */
+    template<typename T>
+    inline void Destroy(entity_t local_id){
+        assert(Has<T>(local_id));
+        MoveRow(local_id, ArchetypeWithout(locations[local_id].archetype, CTTI<T>()));
+    }
+
+    template<typename T>
+    inline T& Get(entity_t local_id){
+        assert(Has<T>(local_id));
+        const auto& loc = locations[local_id];
+        auto& arch = archetypes[loc.archetype];
+        return *static_cast<T*>(arch.At(arch.chunks[loc.chunk], arch.ColumnIndex(CTTI<T>()), loc.row));
+    }
+
+    template<typename T>
+    inline bool Has(entity_t local_id) const{
+        return HasAny(local_id) && archetypes[locations[local_id].archetype].ColumnIndex(CTTI<T>()) >= 0;
+    }
+
+    // returns the "first" of a component type
+    template<typename T>
+    inline T& GetFirst(){
+        T* found = nullptr;
+        for(auto& arch : archetypes){
+            auto col = arch.ColumnIndex(CTTI<T>());
+            if (col >= 0 && !arch.chunks.empty()){
+                found = static_cast<T*>(arch.ColumnBase(arch.chunks.front(), col));
+                break;
+            }
+        }
+        assert(found != nullptr);
+        return *found;
+    }
+
+    /**
+     Destroy all the chunked components on an entity, running each type's remove hooks
+     */
+    void DestroyEntity(entity_t local_id){
+        if (!HasAny(local_id)){
+            return;
+        }
+        const auto loc = locations[local_id];
+        auto& arch = archetypes[loc.archetype];
+        for(uint32_t c = 0; c < arch.columns.size(); c++){
+            arch.columns[c]->remove(arch.At(arch.chunks[loc.chunk], c, loc.row));
+        }
+        CompactRow(loc);
+        locations[local_id] = Location();
+    }
+
+    /**
+     Move all the chunked components on an entity into another storage
+     @param local_id the entity in this storage
+     @param other the destination storage
+     @param other_local_id the entity's id in the destination
+     */
+    void MoveEntityTo(entity_t local_id, ArchetypeStorage& other, entity_t other_local_id){
+        if (!HasAny(local_id)){
+            return;
+        }
+        const auto loc = locations[local_id];
+        auto& arch = archetypes[loc.archetype];
+        auto dest = other.FindOrCreate(arch.columns);
+        if (other_local_id >= other.locations.size()){
+            other.locations.resize(std::max<size_t>(other_local_id + 1, other.locations.size() * 2));
+        }
+        auto newloc = other.AllocateRow(dest, other_local_id);
+        auto& destArch = other.archetypes[dest];
+        for(uint32_t c = 0; c < arch.columns.size(); c++){
+            arch.columns[c]->relocate(destArch.At(destArch.chunks[newloc.chunk], c, newloc.row), arch.At(arch.chunks[loc.chunk], c, loc.row));
+        }
+        other.locations[other_local_id] = newloc;
+        CompactRow(loc);
+        locations[local_id] = Location();
+    }
+
+    /**
+     Get every chunk containing all the requested types
+     @param out the container to fill. It is cleared first.
+     */
+    template<typename ... A, typename container_t>
+    inline void CollectChunks(container_t& out) const{
+        out.clear();
+        for(uint32_t a = 0; a < archetypes.size(); a++){
+            if (archetypes[a].template HasAll<A...>()){
+                for(uint32_t c = 0; c < archetypes[a].chunks.size(); c++){
+                    out.push_back(ChunkRef{a, c});
+                }
+            }
+        }
+    }
+
+    /**
+     Invoke a function on every row of one chunk
+     @param ref the chunk, from CollectChunks
+     @param fn the function to invoke, taking a reference to each type in A
+     */
+    template<typename ... A, typename func_t>
+    inline void ForEachInChunk(const ChunkRef& ref, func_t& fn){
+        auto& arch = archetypes[ref.archetype];
+        auto& chunk = arch.chunks[ref.chunk];
+        std::tuple<A*...> bases{ static_cast<A*>(arch.ColumnBase(chunk, arch.ColumnIndex(CTTI<A>())))... };
+        for(uint32_t row = 0; row < chunk.count; row++){
+            fn(std::get<A*>(bases)[row]...);
+        }
+    }
+
+    /**
+     Invoke a function on every entity that has all of the requested types
+     @param fn the function to invoke, taking a reference to each type in A
+     */
+    template<typename ... A, typename func_t>
+    inline void ForEach(func_t& fn){
+        for(uint32_t a = 0; a < archetypes.size(); a++){
+            if (archetypes[a].template HasAll<A...>()){
+                for(uint32_t c = 0; c < archetypes[a].chunks.size(); c++){
+                    ForEachInChunk<A...>(ChunkRef{a, c}, fn);
+                }
+            }
+        }
+    }
+};
+
+}
@@ -43,3 +43,24 @@ public:
 		mtx.unlock();
 	}	
 };
+
+/**
+ A std::atomic that can be copied, for members of types that are moved around in storage.
+ Copying is not atomic with respect to the source.
+ */
+template<typename T>
+class CopyableAtomic : public std::atomic<T> {
+public:
+	CopyableAtomic(const T& value = T()) : std::atomic<T>(value) {}
+	CopyableAtomic(const CopyableAtomic& other) : std::atomic<T>(other.load()) {}
+
+	inline CopyableAtomic& operator=(const CopyableAtomic& other) {
+		this->store(other.load());
+		return *this;
+	}
+
+	inline CopyableAtomic& operator=(const T& value) {
+		this->store(value);
+		return *this;
+	}
+};
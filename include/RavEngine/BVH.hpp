@@ -0,0 +1,206 @@
+#pragma once
+#include "DataStructures.hpp"
+#include "mathtypes.hpp"
+#include "Frustum.hpp"
+
+namespace RavEngine{
+
+struct AABB{
+    vector3 min{0,0,0}, max{0,0,0};
+
+    static inline AABB FromCenterExtent(const vector3& center, const vector3& extent){
+        return AABB{center - extent, center + extent};
+    }
+
+    inline vector3 Center() const{
+        return (min + max) / decimalType(2);
+    }
+
+    inline vector3 Extent() const{
+        return (max - min) / decimalType(2);
+    }
+
+    inline AABB Union(const AABB& other) const{
+        return AABB{glm::min(min, other.min), glm::max(max, other.max)};
+    }
+
+    inline bool Intersects(const AABB& other) const{
+        return glm::all(glm::lessThanEqual(min, other.max)) && glm::all(glm::lessThanEqual(other.min, max));
+    }
+
+    /**
+     Intersect a ray with this box
+     @param origin the start of the ray
+     @param invDir 1 / the direction of the ray, per component
+     @param maxDistance how far along the ray to look
+     @param distance set to where the ray enters the box, or 0 if it starts inside
+     @return true if the ray hits the box within maxDistance
+     */
+    inline bool IntersectsRay(const vector3& origin, const vector3& invDir, decimalType maxDistance, decimalType& distance) const{
+        const auto t0 = (min - origin) * invDir, t1 = (max - origin) * invDir;
+        const auto tmin = glm::min(t0, t1), tmax = glm::max(t0, t1);
+        const auto enter = std::max({tmin.x, tmin.y, tmin.z, decimalType(0)});
+        const auto exit = std::min({tmax.x, tmax.y, tmax.z, maxDistance});
+        distance = enter;
+        return enter <= exit;
+    }
+};
+
+/**
+ A bounding volume hierarchy over boxes identified by their index. It is built once from a set of boxes,
+ after which boxes can move by updating them and calling Refit, which only recomputes the nodes above
+ the boxes that changed. Refitting does not rebalance the tree, so rebuild it after large changes.
+ */
+class BVH{
+public:
+    constexpr static uint32_t max_leaf_size = Frustum::simd_width;
+
+private:
+    struct Node{
+        AABB bounds;
+        uint32_t first = 0;     // for leaves, the first entry in items. For interior nodes, the right child. The left child always follows its parent.
+        uint32_t count = 0;     // the number of items in a leaf, or 0 for interior nodes
+
+        inline bool IsLeaf() const{
+            return count > 0;
+        }
+    };
+    Vector<Node> nodes;             // in depth-first order, so children always come after their parents
+    Vector<uint32_t> parents;
+    Vector<uint32_t> items;         // item indices, grouped by leaf
+    Vector<AABB> itemBounds;        // by item index
+    Vector<uint32_t> leafOfItem;
+    Vector<uint8_t> dirty;          // by node
+
+    uint32_t Build(uint32_t begin, uint32_t end, uint32_t parent);
+
+    template<typename test_t, typename leaf_t>
+    inline void Traverse(const test_t& test, const leaf_t& leaf) const{
+        if (nodes.empty()){
+            return;
+        }
+        constexpr uint32_t max_depth = 64;       // Build splits at the median, so this is far more than it produces
+        uint32_t stack[max_depth];
+        uint32_t depth = 0;
+        stack[depth++] = 0;
+        while(depth > 0){
+            const auto& node = nodes[stack[--depth]];
+            if (!test(node.bounds)){
+                continue;
+            }
+            if (node.IsLeaf()){
+                leaf(node);
+            }
+            else{
+                assert(depth + 2 <= max_depth);
+                stack[depth++] = node.first;
+                stack[depth++] = static_cast<uint32_t>(&node - nodes.data()) + 1;
+            }
+        }
+    }
+
+public:
+    /**
+     Build the hierarchy, replacing what was there before
+     @param bounds the box of each item
+     @param count the number of items
+     */
+    void Build(const AABB* bounds, size_t count);
+
+    /**
+     Move an item. Call Refit once all the items have been moved.
+     @param item the index of the item, as passed to Build
+     @param bounds its new box
+     */
+    inline void Update(uint32_t item, const AABB& bounds){
+        itemBounds[item] = bounds;
+        dirty[leafOfItem[item]] = 1;
+    }
+
+    /**
+     Recompute the boxes of every node above a moved item
+     */
+    void Refit();
+
+    inline size_t size() const{
+        return itemBounds.size();
+    }
+
+    inline size_t NodeCount() const{
+        return nodes.size();
+    }
+
+    inline const AABB& GetBounds(uint32_t item) const{
+        return itemBounds[item];
+    }
+
+    /**
+     Find the items that may be inside a frustum. Leaf items are tested Frustum::simd_width at a time.
+     @param frustum the frustum to test against
+     @param f called with the index of every item that may be visible
+     */
+    template<typename F>
+    inline void QueryFrustum(const Frustum& frustum, const F& f) const{
+        Traverse([&frustum](const AABB& bounds){
+            return frustum.TestBox(bounds.Center(), bounds.Extent());
+        }, [this,&frustum,&f](const Node& leaf){
+            vector3 centers[max_leaf_size], extents[max_leaf_size];
+            for(uint32_t k = 0; k < leaf.count; k++){
+                const auto& bounds = itemBounds[items[leaf.first + k]];
+                centers[k] = bounds.Center();
+                extents[k] = bounds.Extent();
+            }
+            const auto visible = frustum.TestBoxes(centers, extents, leaf.count);
+            for(uint32_t k = 0; k < leaf.count; k++){
+                if (visible & (1u << k)){
+                    f(items[leaf.first + k]);
+                }
+            }
+        });
+    }
+
+    /**
+     Find the items whose boxes overlap a box
+     @param box the box to test against
+     @param f called with the index of every overlapping item
+     */
+    template<typename F>
+    inline void QueryBox(const AABB& box, const F& f) const{
+        Traverse([&box](const AABB& bounds){
+            return box.Intersects(bounds);
+        }, [this,&box,&f](const Node& leaf){
+            for(uint32_t k = 0; k < leaf.count; k++){
+                const auto item = items[leaf.first + k];
+                if (box.Intersects(itemBounds[item])){
+                    f(item);
+                }
+            }
+        });
+    }
+
+    /**
+     Find the items whose boxes a ray passes through, in no particular order
+     @param origin the start of the ray
+     @param direction the direction of the ray, which does not need to be normalized
+     @param maxDistance how far along the ray to look, in multiples of direction
+     @param f called with the index of every item hit and the distance at which the ray enters its box
+     */
+    template<typename F>
+    inline void QueryRay(const vector3& origin, const vector3& direction, decimalType maxDistance, const F& f) const{
+        // a zero component becomes infinity, which the slab test handles
+        const vector3 invDir = decimalType(1) / direction;
+        decimalType distance;
+        Traverse([&](const AABB& bounds){
+            return bounds.IntersectsRay(origin, invDir, maxDistance, distance);
+        }, [&](const Node& leaf){
+            for(uint32_t k = 0; k < leaf.count; k++){
+                const auto item = items[leaf.first + k];
+                if (itemBounds[item].IntersectsRay(origin, invDir, maxDistance, distance)){
+                    f(item, distance);
+                }
+            }
+        });
+    }
+};
+
+}
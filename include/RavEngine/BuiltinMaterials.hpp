@@ -32,7 +32,7 @@ namespace RavEngine {
             color = c;
         }
 
-        virtual void DrawHook() override;
+        virtual void DrawHook(bgfx::Encoder* encoder) override;
 	protected:
 		Ref<Texture> albedo = TextureManager::defaultTexture;
 		ColorRGBA color{1,1,1,1};
@@ -77,6 +77,6 @@ namespace RavEngine {
 			mat->texture = texture;
 		}
 		
-		void DrawHook() override;
+		void DrawHook(bgfx::Encoder* encoder) override;
 	};
 }
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <string_view>
 #include <type_traits>
+#include <atomic>
 
 #ifdef _WIN32
     #define __PRETTY_FUNCTION__ __FUNCSIG__
@@ -137,4 +138,19 @@ inline static constexpr ctti_t CTTI(){
     return Hash32_CT(type_name<T>());
 }
 
+inline uint32_t NextComponentTypeIndex(){
+    static std::atomic<uint32_t> next = 0;
+    return next++;
+}
+
+/**
+@return a small dense index for a type, assigned the first time it is requested
+@note unlike CTTI, this is only stable for the lifetime of the process, so do not serialize it
+*/
+template<typename T>
+inline uint32_t ComponentTypeIndex(){
+    static const uint32_t index = NextComponentTypeIndex();
+    return index;
+}
+
 }
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+
+namespace tf{
+    class Executor;
+}
+
+namespace RavEngine{
+
+/**
+ Packs the state a draw needs into one integer, so that sorting draws by key puts the ones sharing
+ state next to each other. From the most significant bits: view, program, material, mesh, and a
+ coarse distance from the camera, so that draws with the same state go front to back.
+ */
+struct DrawSortKey{
+    constexpr static uint32_t depthBits = 8, meshBits = 16, materialBits = 16, programBits = 16, viewBits = 8;
+    constexpr static uint32_t meshShift = depthBits, materialShift = meshShift + meshBits, programShift = materialShift + materialBits, viewShift = programShift + programBits;
+    static_assert(viewShift + viewBits == 64, "Sort key fields must fill 64 bits");
+
+    static inline uint64_t Make(uint8_t view, uint16_t program, uint16_t material, uint16_t mesh, uint8_t depth){
+        return (uint64_t(view) << viewShift) | (uint64_t(program) << programShift) | (uint64_t(material) << materialShift) | (uint64_t(mesh) << meshShift) | depth;
+    }
+
+    /**
+     @param distance how far a draw is from the camera
+     @return the depth bucket for a key. Buckets are finer near the camera, where overdraw matters most.
+     */
+    static inline uint8_t DepthBucket(float distance){
+        return static_cast<uint8_t>(std::min(255.f, std::log2(1 + std::max(distance, 0.f)) * 16));
+    }
+
+    static inline uint16_t Program(uint64_t key){
+        return static_cast<uint16_t>(key >> programShift);
+    }
+
+    static inline uint16_t Material(uint64_t key){
+        return static_cast<uint16_t>(key >> materialShift);
+    }
+
+    static inline uint16_t Mesh(uint64_t key){
+        return static_cast<uint16_t>(key >> meshShift);
+    }
+};
+
+/**
+ Sort keys along with a value for each, a byte at a time from the least significant. The sort is stable.
+ Bytes that every key has in common are skipped, so sorting costs nothing for fields that do not vary.
+ @param keys the keys to sort
+ @param values moved along with their keys
+ @param n the number of keys
+ @param executor if given and there are enough keys, each pass is split across its workers. Do not pass the
+ executor whose worker is making the call.
+ */
+void RadixSort(uint64_t* keys, uint32_t* values, size_t n, tf::Executor* executor = nullptr);
+
+}
@@ -42,6 +42,12 @@ struct Entity : public AutoCTTI{
        return Registry::GetComponent<T>(id);
     }
     
+    // record that a component on this entity was modified, so that Changed<T> queries visit it
+    template<typename T>
+    inline void MarkChanged() const{
+        Registry::MarkChanged<T>(id);
+    }
+    
     inline void Destroy(){
         Registry::DestroyEntity(id);
         id = INVALID_ENTITY;
@@ -0,0 +1,112 @@
+#pragma once
+#include "Types.hpp"
+#include <taskflow/taskflow.hpp>
+#include <atomic>
+#include <algorithm>
+
+namespace RavEngine{
+
+enum class ExecutionPolicy : uint8_t{
+    Serial,         // run every entity on one thread
+    StaticChunk,    // hand out fixed-size chunks of entities to the workers
+    Guided,         // Taskflow's guided partitioning, starting with large chunks that shrink
+    Adaptive        // run serially or pick a chunk size from the measured cost per entity
+};
+
+/**
+ Divides a loop over entities between threads according to an ExecutionPolicy. Each System keeps its own,
+ so that the adaptive policy learns that System's cost per entity.
+ */
+struct ExecutionState{
+    ExecutionPolicy policy = ExecutionPolicy::Adaptive;
+    pos_t chunkSize = 1;        // for ExecutionPolicy::StaticChunk
+    double nsPerEntity = 0;     // running average of measured cost, 0 until the loop has run under the adaptive policy
+
+    // below this estimated cost, running on the calling thread is cheaper than spawning tasks
+    constexpr static double adaptive_serial_threshold_ns = 50'000;
+    // adaptive chunks are sized to take about this long
+    constexpr static double adaptive_chunk_target_ns = 20'000;
+
+    /**
+     Run body over [0,n), returning when every index has been visited
+     @param sf the subflow of the calling task, which spawns the other tasks
+     @param n the number of indices
+     @param numWorkers the number of threads that can run tasks, including the calling one
+     @param body invoked with each index. Each task works on its own copy.
+     */
+    template<typename body_t>
+    inline void ForEach(tf::Subflow& sf, pos_t n, pos_t numWorkers, const body_t& body){
+        if (n == 0){
+            return;
+        }
+        switch(policy){
+            case ExecutionPolicy::Serial:{
+                auto serialBody = body;
+                for(pos_t i = 0; i < n; i++){
+                    serialBody(i);
+                }
+            }
+                break;
+            case ExecutionPolicy::StaticChunk:{
+                std::atomic<uint64_t> elapsed = 0;
+                RunChunks(sf, n, numWorkers, chunkSize, body, elapsed);
+            }
+                break;
+            case ExecutionPolicy::Guided:
+                sf.for_each_index(pos_t(0), n, pos_t(1), body);
+                sf.join();
+                break;
+            case ExecutionPolicy::Adaptive:{
+                std::atomic<uint64_t> elapsed = 0;
+                const bool measured = nsPerEntity > 0;
+                if (numWorkers <= 1 || (measured ? nsPerEntity * n < adaptive_serial_threshold_ns : n <= numWorkers)){
+                    auto begin = e_clock_t::now();
+                    auto serialBody = body;
+                    for(pos_t i = 0; i < n; i++){
+                        serialBody(i);
+                    }
+                    elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(e_clock_t::now() - begin).count();
+                }
+                else{
+                    // until the cost is known, start with a few chunks per worker
+                    pos_t adaptiveChunkSize = measured ? static_cast<pos_t>(adaptive_chunk_target_ns / nsPerEntity) : n / (numWorkers * 4);
+                    adaptiveChunkSize = std::clamp<pos_t>(adaptiveChunkSize, 1, n);
+                    RunChunks(sf, n, numWorkers, adaptiveChunkSize, body, elapsed);
+                }
+                const double sample = std::max(static_cast<double>(elapsed) / n, 1.0);
+                nsPerEntity = measured ? nsPerEntity * 0.75 + sample * 0.25 : sample;
+            }
+                break;
+        }
+    }
+
+private:
+    // run body over [0,n) in chunks pulled from a shared counter, adding the time spent to elapsedNs
+    template<typename body_t>
+    static inline void RunChunks(tf::Subflow& sf, pos_t n, pos_t numWorkers, pos_t chunkSize, const body_t& body, std::atomic<uint64_t>& elapsedNs){
+        chunkSize = std::min(chunkSize, n);     // so that the shared counter cannot wrap around
+        const auto n_chunks = (n + chunkSize - 1) / chunkSize;
+        const auto n_tasks = std::min(numWorkers, n_chunks);
+        std::atomic<pos_t> next = 0;
+        auto run = [&next, n, chunkSize, &elapsedNs](body_t body){
+            auto begin = e_clock_t::now();
+            pos_t start;
+            while ((start = next.fetch_add(chunkSize, std::memory_order_relaxed)) < n){
+                const auto end = std::min(n, start + chunkSize);
+                for(pos_t i = start; i < end; i++){
+                    body(i);
+                }
+            }
+            elapsedNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(e_clock_t::now() - begin).count(), std::memory_order_relaxed);
+        };
+        for(pos_t t = 1; t < n_tasks; t++){
+            sf.silent_async([run, body]{
+                run(body);
+            });
+        }
+        run(body);      // the calling thread takes part too
+        sf.join();
+    }
+};
+
+}
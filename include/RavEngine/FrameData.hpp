@@ -11,22 +11,97 @@
 #include "mathtypes.hpp"
 #include <ozz/base/containers/vector.h>
 #include "GUI.hpp"
+#include "Types.hpp"
+#include <array>
+#include <atomic>
 
 namespace RavEngine {
 
 class MaterialInstanceBase;
 struct DirectionalLight;
 
+/**
+ The world matrix of one mesh instance, as the first three rows of the matrix. The last row of an
+ affine transform is always [0,0,0,1], so the shader rebuilds it instead. This is the layout of the
+ instance data buffer and of skinning palettes, so a row of these can be uploaded with a single copy.
+ */
+struct InstanceTransform{
+    std::array<float, 12> rows;
+    
+    InstanceTransform(){}
+    InstanceTransform(const matrix4& m){
+        for(int r = 0; r < 3; r++){
+            for(int c = 0; c < 4; c++){
+                rows[r * 4 + c] = static_cast<float>(m[c][r]);
+            }
+        }
+    }
+};
+static_assert(sizeof(InstanceTransform) % 16 == 0, "Instance data strides must be a multiple of 16 bytes");
+
+/**
+ Instance data memory taken from the renderer's transient buffers before extraction, so that extraction can
+ write instances where the GPU reads them instead of into a row's items, saving a copy when drawing. It is
+ sized from what the previous frame asked for. Requests that do not fit fail, and the caller writes into
+ items as before; the next frame then reserves enough for them.
+ */
+struct InstanceArena{
+    bgfx::InstanceDataBuffer idb{};
+    uint32_t capacity = 0;
+    std::atomic<uint32_t> requested = 0;    // can pass capacity, which is how overflow is seen
+    
+    /**
+     Take this frame's memory. Call on the render API thread before extraction starts. The memory is
+     released when the frame is submitted.
+     @param count the number of instances to reserve. Fewer are reserved if the transient buffer is short.
+     */
+    inline void Reserve(uint32_t count){
+        requested = 0;
+        capacity = count > 0 ? bgfx::getAvailInstanceDataBuffer(count, sizeof(InstanceTransform)) : 0;
+        if (capacity > 0){
+            bgfx::allocInstanceDataBuffer(&idb, capacity, sizeof(InstanceTransform));
+        }
+        else{
+            idb = {};
+        }
+    }
+    
+    /**
+     Claim room for instances. Safe to call from any thread.
+     @param count the number of instances
+     @return the index of the first one, or INVALID_INDEX if they do not fit
+     */
+    inline uint32_t Allocate(uint32_t count){
+        const auto first = requested.fetch_add(count, std::memory_order_relaxed);
+        return first + count <= capacity ? first : INVALID_INDEX;
+    }
+    
+    inline InstanceTransform* Get(uint32_t first){
+        return reinterpret_cast<InstanceTransform*>(idb.data) + first;
+    }
+    
+    /**
+     @return how many instances to reserve for the next frame, with some room to grow
+     */
+    inline uint32_t NextReservation() const{
+        const auto r = requested.load(std::memory_order_relaxed);
+        return r + r / 4;
+    }
+};
+
 struct FrameData{
 	//global matrices
 	matrix4 viewmatrix, projmatrix;
 	vector3 cameraWorldpos;
+	float nearClip = 0, farClip = 0;	// 0 when there is no active camera
     
 	// these need to be ordered to
 	// ensure skinning data gets correct matrices
 	template<typename T>
     struct entry{
         Vector<T> items;
+        // instances written into the InstanceArena rather than items, which are drawn before items
+        uint32_t arenaFirst = INVALID_INDEX, arenaCount = 0;
         //SpinLock mtx;
         
         inline void AddItem(const typename decltype(items)::value_type& item){
@@ -36,6 +111,16 @@ struct FrameData{
         }
         inline void clear(){
             items.clear();
+            arenaFirst = INVALID_INDEX;
+            arenaCount = 0;
+        }
+        
+        inline size_t size() const{
+            return items.size() + arenaCount;
+        }
+        
+        inline void AppendTo(entry& other) const{
+            other.items.insert(other.items.end(), items.begin(), items.end());
         }
     };
     
@@ -43,23 +128,47 @@ struct FrameData{
     struct skinningEntry : public entry<T>{
         //SpinLock skinningMtx;
         
-        //used by skinned mesh
-        ozz::vector<ozz::vector<T>> skinningdata;
+        //used by skinned mesh. The palettes of every instance, one after another in upload layout.
+        Vector<InstanceTransform> skinningdata;
         
-        inline void AddSkinningData(const typename decltype(skinningdata)::value_type& item){
+        inline void AddSkinningData(const ozz::vector<InstanceTransform>& palette){
             //skinningMtx.lock();
-            skinningdata.push_back(item);
+            skinningdata.insert(skinningdata.end(), palette.begin(), palette.end());
             //skinningMtx.unlock();
         }
         inline void clear(){
             entry<T>::clear();
             skinningdata.clear();
         }
+        
+        inline void AppendTo(skinningEntry& other) const{
+            entry<T>::AppendTo(other);
+            other.skinningdata.insert(other.skinningdata.end(), skinningdata.begin(), skinningdata.end());
+        }
     };
+    
+    /**
+     Append the rows of a per-thread bucket to the matching rows of a map, and empty the bucket's rows while keeping
+     their memory for the next frame. Rows that were already empty are dropped, so the bucket does not keep their assets alive.
+     @param bucket the rows to move
+     @param target the rows to append to
+     */
+    template<typename map_t>
+    static inline void MergeBucket(map_t& bucket, map_t& target){
+        for(auto it = bucket.begin(); it != bucket.end();){
+            if (it->second.items.empty()){
+                it = bucket.erase(it);
+                continue;
+            }
+            it->second.AppendTo(target[it->first]);
+            it->second.clear();
+            ++it;
+        }
+    }
 	
 	//opaque pass data
-	UnorderedMap<std::tuple<Ref<MeshAsset>, Ref<MaterialInstanceBase>>,entry<matrix4>/*,SpinLock*/> opaques;
-    UnorderedMap<std::tuple<Ref<MeshAssetSkinned>, Ref<MaterialInstanceBase>,Ref<SkeletonAsset>>, skinningEntry<matrix4>/*,SpinLock*/> skinnedOpaques;
+	UnorderedMap<std::tuple<Ref<MeshAsset>, Ref<MaterialInstanceBase>>,entry<InstanceTransform>/*,SpinLock*/> opaques;
+    UnorderedMap<std::tuple<Ref<MeshAssetSkinned>, Ref<MaterialInstanceBase>,Ref<SkeletonAsset>>, skinningEntry<InstanceTransform>/*,SpinLock*/> skinnedOpaques;
 	
 	template<typename T>
 	struct StoredLight{
@@ -117,6 +226,9 @@ struct FrameData{
 		PackedDL(const DirectionalLight& l, const tinyvec3& tv) : light(l), rotation(tv){}
 	};
 	
+	// instance memory for this frame, which Clear leaves alone since it is taken before extraction
+	InstanceArena instanceArena;
+	
 	//lighting data
     Vector<PackedDL> directionals;
     Vector<AmbientLight> ambients;
@@ -135,7 +247,22 @@ struct FrameData{
         }
     }
 	
+    // objects rejected and kept by frustum culling this frame
+    uint32_t culledObjects = 0, submittedObjects = 0;
+    // point and spot lights rejected and kept by frustum culling
+    uint32_t culledLights = 0, submittedLights = 0;
+    // objects rejected and kept by the volume of each shadow-casting light, summed over the lights
+    uint32_t culledShadowCasters = 0, submittedShadowCasters = 0;
+	
 	inline void Clear(){
+        nearClip = 0;
+        farClip = 0;
+        culledObjects = 0;
+        submittedObjects = 0;
+        culledLights = 0;
+        submittedLights = 0;
+        culledShadowCasters = 0;
+        submittedShadowCasters = 0;
         ResetMap(opaques);
         ResetMap(skinnedOpaques);
 		directionals.clear();
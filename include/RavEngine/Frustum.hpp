@@ -0,0 +1,60 @@
+#pragma once
+#include "mathtypes.hpp"
+#include "MeshAsset.hpp"
+#include <array>
+
+namespace RavEngine{
+
+/**
+ The six planes of a view-projection matrix, for culling world-space boxes.
+ A default-constructed Frustum has no planes and reports everything as visible.
+ */
+struct Frustum{
+    constexpr static size_t simd_width = 4;
+
+    // a, b, c, d of each plane, with the normal pointing inwards. They are not normalized,
+    // because only the sign of the distance matters.
+    std::array<std::array<float, 4>, 6> planes{};
+
+    Frustum(){}
+
+    /**
+     @param viewProj projection * view. The near plane is taken as the OpenGL one, which also
+     contains everything in front of a [0,1] depth range near plane.
+     */
+    Frustum(const matrix4& viewProj);
+
+    /**
+     Compute the world-space axis-aligned box around a transformed local box
+     @param transform the world matrix
+     @param local the box in local space
+     @param center the center of the world-space box
+     @param extent the half size of the world-space box
+     */
+    static void TransformBounds(const matrix4& transform, const MeshAsset::Bounds& local, vector3& center, vector3& extent);
+
+    /**
+     Test up to simd_width boxes at once
+     @param centers the world-space centers
+     @param extents the world-space half sizes
+     @param n the number of boxes, at most simd_width
+     @return one bit per box, set if the box may be visible
+     */
+    uint32_t TestBoxes(const vector3* centers, const vector3* extents, size_t n) const;
+
+    inline bool TestBox(const vector3& center, const vector3& extent) const{
+        return TestBoxes(&center, &extent, 1) != 0;
+    }
+
+    /**
+     Copy the transforms whose copy of a local box may be visible
+     @param transforms the world matrices to test
+     @param n the number of transforms
+     @param local the box shared by all of them
+     @param out where to write the visible transforms, with room for n. May be the same as transforms.
+     @return the number of transforms written
+     */
+    size_t CullTransforms(const matrix4* transforms, size_t n, const MeshAsset::Bounds& local, matrix4* out) const;
+};
+
+}
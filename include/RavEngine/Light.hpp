@@ -96,6 +96,12 @@ struct DirectionalLight : public ShadowLight, public QueryableDelta<QueryableDel
 	
 	void DebugDraw(RavEngine::DebugDrawer&, const Transform&) const override;
 	
+	/**
+	 @param transform the Transform of the light's owner
+	 @return the world-space direction of the light, which is the owner's up vector after the rotations of its parents
+	 */
+	static vector3 Direction(const Transform& transform);
+	
 	/**
 	 Structure
 	 @code
@@ -135,6 +141,22 @@ struct DirectionalLight : public ShadowLight, public QueryableDelta<QueryableDel
 		return sizeof(float) * 3;
 	}
 	
+	/**
+	 Calculate the view matrix of the shadow map
+	 @param direction the world-space direction of the light, as sent in the instance data
+	 */
+	static inline matrix4 ShadowViewMatrix(const vector3& direction){
+		return glm::lookAt(direction * decimalType(-25), vector3(0, 0, 0), vector3(0, 1, 0));
+	}
+	
+	/**
+	 Calculate the projection matrix of the shadow map, which covers a fixed area around the origin
+	 */
+	static inline matrix4 ShadowProjectionMatrix(){
+		constexpr decimalType size = 20;
+		return glm::ortho<decimalType>(-size, size, -size, size, 0.5, 100);	// TODO: don't hardcode far clip
+	}
+	
 	/**
 	 Execute instanced draw call for this light type
 	 */
@@ -193,6 +215,13 @@ struct PointLight : public ShadowLight, public QueryableDelta<QueryableDelta<Lig
 		return glm::scale(mat, vector3(radius,radius,radius));
 	}
 	
+	/**
+	 @return the radius of the light's volume before the matrix from CalculateMatrix is applied
+	 */
+	constexpr inline float VolumeRadius() const{
+		return 1;	// the matrix is already scaled to the radius
+	}
+	
 	/**
 	 Execute instanced draw call for this light type
 	 */
@@ -267,6 +296,13 @@ struct SpotLight : public ShadowLight, public QueryableDelta<QueryableDelta<Ligh
 		// no transformations occur, the cone is extended in the vertex shader
 		return mat;
 	}
+	
+	/**
+	 @return the radius of the light's volume before the matrix from CalculateMatrix is applied
+	 */
+	constexpr inline float VolumeRadius() const{
+		return Intensity * 2;	// the vertex shader extends the cone to this length from its tip
+	}
 };
 
 class LightManager{
@@ -0,0 +1,82 @@
+#pragma once
+#include "DataStructures.hpp"
+#include "mathtypes.hpp"
+#include "BVH.hpp"
+#include <array>
+
+namespace RavEngine{
+
+/**
+ Assigns lights to a view-space grid of froxels, so that shading only has to consider the lights
+ near each pixel. The grid is split evenly in screen space and exponentially in depth. Slices can
+ be assigned in parallel, after which Pack gathers the result into one buffer for the GPU.
+ The World does not build the grid yet, because lighting still draws one volume per light and no shader reads it.
+ */
+class LightClusters{
+public:
+    constexpr static uint32_t gridX = 16, gridY = 9, gridZ = 24;
+    constexpr static uint32_t numClusters = gridX * gridY * gridZ;
+    constexpr static uint32_t maxLightsPerCluster = 128;    // lights past this in a cluster are dropped
+
+private:
+    Vector<AABB> clusterBounds;     // in view space, by cluster index
+    std::array<float, gridZ + 1> sliceDepths;   // distance in front of the camera where each slice begins
+    matrix4 projection{0};
+    float nearClip = 0, farClip = 0;
+
+    Vector<vector4> lights;         // view-space center and radius
+    Vector<uint32_t> counts;        // by cluster
+    Vector<uint32_t> slots;         // maxLightsPerCluster per cluster
+    Vector<uint32_t> packed;
+
+public:
+    static inline uint32_t Index(uint32_t x, uint32_t y, uint32_t z){
+        return (z * gridY + y) * gridX + x;
+    }
+
+    /**
+     Set the camera the grid is built for. The cluster bounds are only recomputed when these change.
+     @param projection the camera's projection matrix
+     @param nearClip distance to the near plane
+     @param farClip distance to the far plane
+     */
+    void SetView(const matrix4& projection, float nearClip, float farClip);
+
+    /**
+     Start assigning a set of lights, clearing the previous assignment
+     @param spheres the view-space center (xyz) and radius (w) of each light's volume
+     @param count the number of lights. Light indices in the result refer to this order.
+     */
+    void BeginAssign(const vector4* spheres, size_t count);
+
+    /**
+     Assign the lights to one depth slice. Different slices may be assigned at the same time.
+     @param z the slice, less than gridZ
+     */
+    void AssignSlice(uint32_t z);
+
+    /**
+     Gather the assignment into one buffer, laid out as an (offset, count) pair for each cluster
+     followed by the light indices. Offsets are from the start of the buffer.
+     */
+    const Vector<uint32_t>& Pack();
+
+    /**
+     @return the cluster containing a view-space position, or INVALID_INDEX if it is outside the grid
+     */
+    uint32_t ClusterOf(const vector3& viewPosition) const;
+
+    inline uint32_t GetCount(uint32_t cluster) const{
+        return counts[cluster];
+    }
+
+    inline const uint32_t* GetLights(uint32_t cluster) const{
+        return slots.data() + cluster * maxLightsPerCluster;
+    }
+
+    inline const AABB& GetBounds(uint32_t cluster) const{
+        return clusterBounds[cluster];
+    }
+};
+
+}
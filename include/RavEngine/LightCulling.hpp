@@ -0,0 +1,110 @@
+#pragma once
+#include "Frustum.hpp"
+#include "BVH.hpp"
+#include "Light.hpp"
+#include "DataStructures.hpp"
+
+namespace RavEngine{
+
+/**
+ @param light a point or spot light
+ @param lightMatrix the matrix from the light's CalculateMatrix
+ @return the world-space box around the volume the light draws
+ */
+template<typename T>
+inline AABB LightVolume(const T& light, const matrix4& lightMatrix){
+    const auto r = light.VolumeRadius();
+    MeshAsset::Bounds local;
+    for(int axis = 0; axis < 3; axis++){
+        local.min[axis] = -r;
+        local.max[axis] = r;
+    }
+    vector3 center, extent;
+    Frustum::TransformBounds(lightMatrix, local, center, extent);
+    return AABB::FromCenterExtent(center, extent);
+}
+
+/**
+ What a frame can see: the camera's frustum, and the volumes of the shadow-casting lights. Lights the camera cannot
+ see are culled. Meshes the camera cannot see are still kept if they are inside a shadow-casting light's volume,
+ because their shadows may fall somewhere the camera can see.
+ */
+struct CullingVolumes{
+    Frustum camera;                 // of the active camera, or empty if there is none
+    Vector<Frustum> shadowFrusta;   // of the shadow-casting directional lights
+    Vector<AABB> shadowBoxes;       // of the shadow-casting point and spot lights
+
+    inline void ClearShadowVolumes(){
+        shadowFrusta.clear();
+        shadowBoxes.clear();
+    }
+
+    inline size_t NumShadowVolumes() const{
+        return shadowFrusta.size() + shadowBoxes.size();
+    }
+
+    /**
+     @param light a point or spot light
+     @param lightMatrix the matrix from the light's CalculateMatrix
+     @return true if the camera may see part of the light's volume
+     */
+    template<typename T>
+    inline bool LightVisible(const T& light, const matrix4& lightMatrix) const{
+        const auto volume = LightVolume(light, lightMatrix);
+        return camera.TestBox(volume.Center(), volume.Extent());
+    }
+
+    /**
+     Add the shadow map's volume of a directional light, if it casts shadows
+     @param direction the world-space direction of the light
+     */
+    inline void AddShadowVolume(const DirectionalLight& light, const vector3& direction){
+        if (light.CastsShadows()){
+            shadowFrusta.emplace_back(DirectionalLight::ShadowProjectionMatrix() * DirectionalLight::ShadowViewMatrix(direction));
+        }
+    }
+
+    /**
+     Add the volume of a point or spot light, if it casts shadows
+     @param transform the world matrix of the light's owner
+     */
+    template<typename T>
+    inline void AddShadowVolume(const T& light, const matrix4& transform){
+        if (light.CastsShadows()){
+            shadowBoxes.push_back(LightVolume(light, light.CalculateMatrix(transform)));
+        }
+    }
+
+    /**
+     Test up to Frustum::simd_width boxes against the camera and the shadow-casting lights
+     @param centers the world-space centers
+     @param extents the world-space half sizes
+     @param n the number of boxes
+     @param castersFound incremented once for each box inside each light's volume
+     @return one bit per box, set if the camera or a light may see it
+     */
+    inline uint32_t TestBoxes(const vector3* centers, const vector3* extents, size_t n, uint32_t& castersFound) const{
+        auto visible = camera.TestBoxes(centers, extents, n);
+        auto addCasters = [&visible, &castersFound, n](uint32_t casters){
+            visible |= casters;
+            for(size_t k = 0; k < n; k++){
+                castersFound += (casters >> k) & 1;
+            }
+        };
+        for(const auto& volume : shadowFrusta){
+            addCasters(volume.TestBoxes(centers, extents, n));
+        }
+        for(const auto& volume : shadowBoxes){
+            uint32_t casters = 0;
+            for(size_t k = 0; k < n; k++){
+                if (volume.Intersects(AABB::FromCenterExtent(centers[k], extents[k]))){
+                    casters |= 1u << k;
+                }
+            }
+            addCasters(casters);
+        }
+        return visible;
+    }
+};
+
+}
@@ -30,9 +30,14 @@ namespace RavEngine {
 		
 		/**
 		Enqueue commands to execute on the GPU
-		@param commands the command buffer to write to
+		@param encoder the encoder to record to. Each thread submitting draws needs its own.
 		*/
-		void Draw(const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, int view = 0);
+		void Draw(bgfx::Encoder* encoder, const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, int view = 0);
+		
+		// record to the render thread's encoder
+		inline void Draw(const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, int view = 0){
+			Draw(bgfx::begin(), vertexBuffer, indexBuffer, view);
+		}
 		
 		/**
 		 Static singleton for managing materials
@@ -77,7 +82,14 @@ namespace RavEngine {
 	class MaterialInstanceBase {
 	public:
         bool doubleSided = false;
-		virtual void Draw(const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, const matrix4& worldmatrix, int view = 0) = 0;
+		virtual void Draw(bgfx::Encoder* encoder, const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, const matrix4& worldmatrix, int view = 0) = 0;
+		
+		// record to the render thread's encoder
+		inline void Draw(const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, const matrix4& worldmatrix, int view = 0){
+			Draw(bgfx::begin(), vertexBuffer, indexBuffer, worldmatrix, view);
+		}
+		// the program Draw submits with, for ordering draws by state
+		virtual bgfx::ProgramHandle GetProgram() const = 0;
 	};
 
 	/**
@@ -87,21 +99,27 @@ namespace RavEngine {
 	class MaterialInstance : public MaterialInstanceBase {
 	protected:
 		/**
-		* Allows you to perform work before Draw executes. Use this to bind uniforms.
+		* Allows you to perform work before Draw executes. Use this to bind uniforms. Draws can be recorded from
+		* several threads at once, so bind through the encoder and do not modify shared state.
+		* @param encoder the encoder the draw is being recorded to
 		*/
-		virtual void DrawHook() {};
+		virtual void DrawHook(bgfx::Encoder* encoder) {};
 	public:
 		virtual ~MaterialInstance() {}
-        inline void Draw(const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, const matrix4& worldmatrix, int view = 0) override{
-			DrawHook();
+		using MaterialInstanceBase::Draw;
+        inline void Draw(bgfx::Encoder* encoder, const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, const matrix4& worldmatrix, int view = 0) override{
+			DrawHook(encoder);
 			float transmat[16];
             copyMat4((const decimalType*)glm::value_ptr(worldmatrix), transmat);
-			bgfx::setTransform(transmat);
-			mat->Draw(vertexBuffer, indexBuffer, view);
+			encoder->setTransform(transmat);
+			mat->Draw(encoder, vertexBuffer, indexBuffer, view);
 		}
 		auto GetHandle() const {
 			return mat->program;
 		}
+		bgfx::ProgramHandle GetProgram() const override {
+			return mat->program;
+		}
 	protected:
 		MaterialInstance(Ref<T> m) : mat(m) {}
 		Ref<T> mat;
@@ -0,0 +1,103 @@
+#pragma once
+#include "DataStructures.hpp"
+#include <array>
+#include <memory>
+#include <algorithm>
+
+namespace RavEngine{
+
+/**
+ A sparse array split into fixed-size pages, which are allocated when a value is first written to them
+ and freed when their last value is erased. Memory use follows the number of stored values rather than
+ the largest index.
+ @param T the value type
+ @param empty_value the value reported for indices that have not been set
+ @param page_size the number of values per page
+ */
+template<typename T, T empty_value, size_t page_size = 1024>
+class PagedSparseArray{
+    struct Page{
+        std::array<T, page_size> values;
+        size_t occupied = 0;
+        Page(){
+            values.fill(empty_value);
+        }
+    };
+    Vector<std::unique_ptr<Page>> pages;
+
+public:
+    /**
+     @return the value at an index, or empty_value if it has not been set
+     */
+    inline T get(size_t idx) const{
+        auto page = idx / page_size;
+        if (page >= pages.size() || !pages[page]){
+            return empty_value;
+        }
+        return pages[page]->values[idx % page_size];
+    }
+
+    inline bool contains(size_t idx) const{
+        return get(idx) != empty_value;
+    }
+
+    /**
+     Set a value, allocating its page if necessary
+     @param idx the index to write
+     @param value the value to write. Use erase to clear an index.
+     */
+    inline void set(size_t idx, T value){
+        auto page = idx / page_size;
+        if (page >= pages.size()){
+            pages.resize(page + 1);
+        }
+        if (!pages[page]){
+            pages[page] = std::make_unique<Page>();
+        }
+        auto& slot = pages[page]->values[idx % page_size];
+        if (slot == empty_value){
+            pages[page]->occupied++;
+        }
+        slot = value;
+    }
+
+    /**
+     Clear a value, freeing its page if it was the last one on it
+     @param idx the index to clear
+     */
+    inline void erase(size_t idx){
+        auto page = idx / page_size;
+        if (page >= pages.size() || !pages[page]){
+            return;
+        }
+        auto& slot = pages[page]->values[idx % page_size];
+        if (slot != empty_value){
+            slot = empty_value;
+            if (--pages[page]->occupied == 0){
+                pages[page].reset();
+            }
+        }
+    }
+
+    /**
+     Make room in the page table for indices up to max_idx. Pages are still allocated on demand.
+     */
+    inline void reserve(size_t max_idx){
+        auto n_pages = max_idx / page_size + 1;
+        if (n_pages > pages.size()){
+            pages.resize(n_pages);
+        }
+    }
+
+    /**
+     @return the number of bytes used by the page table and the allocated pages
+     */
+    inline size_t memory_usage() const{
+        auto n_allocated = std::count_if(pages.begin(), pages.end(), [](const auto& page){
+            return static_cast<bool>(page);
+        });
+        return pages.capacity() * sizeof(typename decltype(pages)::value_type) + n_allocated * sizeof(Page);
+    }
+};
+
+}
@@ -39,6 +39,16 @@ class Registry{
         return id;
     }
     
+    // invoked by the world. The ids are consecutive, so they never come from the available queue
+    static inline entity_t CreateEntities(World* world, const entity_t firstIdInWorld, const entity_t count){
+        auto first = static_cast<entity_t>(entityData.size());
+        entityData.reserve(entityData.size() + count);
+        for(entity_t i = 0; i < count; i++){
+            entityData.emplace_back(world,firstIdInWorld + i);
+        }
+        return first;
+    }
+    
     // invoked by the world
     static inline void DestroyEntity(entity_t global_id){
         auto& data = entityData[global_id];
@@ -77,6 +87,13 @@ class Registry{
         return data.world->GetComponent<T>(data.idInWorld);
     }
 
+    template<typename T>
+    static inline void MarkChanged(entity_t id){
+        assert(EntityIsValid(id));
+        auto& data = entityData[id];
+        data.world->MarkChanged<T>(data.idInWorld);
+    }
+
     template<typename T>
     static inline bool HasComponent(entity_t id) {
         assert(EntityIsValid(id));
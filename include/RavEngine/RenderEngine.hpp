@@ -168,8 +168,11 @@ namespace RavEngine {
 		
 		//to reduce magic numbers
 		struct Views{
+			// each encoder recording geometry gets its own view, because bgfx would interleave their draws within one view
+			constexpr static bgfx::ViewId numGeometryViews = 8;
 			enum : bgfx::ViewId{
 				DeferredGeo,
+				DeferredGeoLast = DeferredGeo + numGeometryViews - 1,
 				LightingNoShadows,
                 LightingShadowsFirstView,
                 FinalBlit = BGFX_CONFIG_MAX_VIEWS - 1,       // views are sorted in ascending order, so force this to go at the very end
@@ -231,6 +234,18 @@ namespace RavEngine {
             return totalVRAM;
         }
         
+        struct DrawStats{
+            uint32_t draws = 0, programChanges = 0, materialChanges = 0, meshChanges = 0;
+        };
+        
+        /**
+         @return how often the geometry pass switched program, material, and mesh between draws last frame. The geometry
+         views are sequential, so this is the order the draws were submitted to the GPU in.
+         */
+        const DrawStats& GetLastDrawStats() const{
+            return drawStats;
+        }
+        
     protected:
         static RavEngine::Vector<VertexColorUV> navMeshPolygon;
         static bgfx::VertexLayout debugNavMeshLayout;
@@ -251,6 +266,7 @@ namespace RavEngine {
 #endif
 		
 		float currentFrameTime;
+		DrawStats drawStats;
 
 		static SDL_Window* window;
 		void* metalLayer;
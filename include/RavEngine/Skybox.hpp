@@ -11,11 +11,12 @@ namespace RavEngine {
 
 	// subclass
 	struct ISkyMaterialInstance : public MaterialInstance<ISkyMaterial> {
-		inline void Draw(const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, const matrix4& worldmatrix, int view = 0) override{
+		using MaterialInstance::Draw;
+		inline void Draw(bgfx::Encoder* encoder, const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, const matrix4& worldmatrix, int view = 0) override{
 			float transmat[16];
 			copyMat4((const decimalType*)glm::value_ptr(worldmatrix), transmat);
-			bgfx::setTransform(transmat);
-			mat->Draw(vertexBuffer, indexBuffer, view);
+			encoder->setTransform(transmat);
+			mat->Draw(encoder, vertexBuffer, indexBuffer, view);
 		}
 		ISkyMaterialInstance(const Ref<ISkyMaterial> sm) : MaterialInstance(sm) {}
 	};
@@ -27,7 +28,7 @@ namespace RavEngine {
 	};
 
 	struct DefaultSkyMaterialInstance : public  ISkyMaterialInstance {
-		void DrawHook() override {
+		void DrawHook(bgfx::Encoder* encoder) override {
 			// set uniforms here...
 		}
 		DefaultSkyMaterialInstance(const Ref<ISkyMaterial> smi) : ISkyMaterialInstance(smi) {}
@@ -0,0 +1,145 @@
+#pragma once
+#include "DataStructures.hpp"
+#include "PagedSparseArray.hpp"
+#include "Types.hpp"
+#include <algorithm>
+
+namespace RavEngine{
+
+/**
+ Entities grouped by a key, such as a StaticMesh's mesh and material, kept between frames so that each frame
+ only writes per-entity data into stable slots instead of regrouping. Removing a member moves the batch's last
+ member into its slot. An emptied batch gives up its key and is reused by the next new key.
+ @param key_t the grouping key, which must be hashable
+ */
+template<typename key_t>
+class StaticBatches{
+public:
+    struct Batch{
+        key_t key;
+        Vector<entity_t> members;   // local ids, in slot order
+    };
+
+private:
+    Vector<Batch> batches;
+    Vector<pos_t> freeBatches;
+    UnorderedMap<key_t, pos_t> batchOfKey;
+    PagedSparseArray<pos_t, INVALID_INDEX> batchOf, slotOf;     // by local id
+    Vector<pos_t> offsets;      // first flattened index of each batch, as of the last Layout
+
+public:
+    /**
+     @param local_id the entity to add, which must not already be in a batch
+     @param key the batch to add it to, which is created if needed
+     */
+    inline void Add(entity_t local_id, const key_t& key){
+        pos_t b;
+        auto it = batchOfKey.find(key);
+        if (it != batchOfKey.end()){
+            b = it->second;
+        }
+        else{
+            if (!freeBatches.empty()){
+                b = freeBatches.back();
+                freeBatches.pop_back();
+            }
+            else{
+                b = static_cast<pos_t>(batches.size());
+                batches.emplace_back();
+            }
+            batches[b].key = key;
+            batchOfKey.emplace(key, b);
+        }
+        auto& members = batches[b].members;
+        batchOf.set(local_id, b);
+        slotOf.set(local_id, static_cast<pos_t>(members.size()));
+        members.push_back(local_id);
+    }
+
+    // @param local_id an entity in a batch
+    inline void Remove(entity_t local_id){
+        const auto b = batchOf.get(local_id);
+        const auto slot = slotOf.get(local_id);
+        auto& batch = batches[b];
+        // the last member takes the removed one's slot
+        const auto moved = batch.members.back();
+        batch.members[slot] = moved;
+        slotOf.set(moved, slot);
+        batch.members.pop_back();
+        batchOf.erase(local_id);
+        slotOf.erase(local_id);
+        if (batch.members.empty()){
+            // do not keep what the key refers to alive
+            batchOfKey.erase(batch.key);
+            batch.key = {};
+            freeBatches.push_back(b);
+        }
+    }
+
+    // @return the batch an entity is in, or INVALID_INDEX
+    inline pos_t BatchOf(entity_t local_id) const{
+        return batchOf.get(local_id);
+    }
+
+    inline pos_t SlotOf(entity_t local_id) const{
+        return slotOf.get(local_id);
+    }
+
+    // every batch by index, including emptied ones waiting for reuse
+    inline const Vector<Batch>& GetBatches() const{
+        return batches;
+    }
+
+    /**
+     Number every member across all batches, batch by batch, for a frame's flat arrays
+     @return the number of members
+     */
+    inline pos_t Layout(){
+        offsets.clear();
+        pos_t total = 0;
+        for(const auto& batch : batches){
+            offsets.push_back(total);
+            total += static_cast<pos_t>(batch.members.size());
+        }
+        return total;
+    }
+
+    // @return the first flattened index of a batch, as of the last Layout
+    inline pos_t Offset(pos_t batch) const{
+        return offsets[batch];
+    }
+
+    // @return the flattened index of an entity in a batch, as of the last Layout
+    inline pos_t FlatIndex(entity_t local_id) const{
+        return offsets[batchOf.get(local_id)] + slotOf.get(local_id);
+    }
+
+    /**
+     @param i a flattened index, less than the total from the last Layout
+     @return the batch and slot at that index
+     */
+    inline std::pair<pos_t, pos_t> Locate(pos_t i) const{
+        // empty batches share their offset with the next one, so this finds the batch that owns i
+        const auto b = static_cast<pos_t>(std::upper_bound(offsets.begin(), offsets.end(), i) - offsets.begin() - 1);
+        return {b, i - offsets[b]};
+    }
+
+    /**
+     Number the kept slots of a batch in order, so that only they need room in the output and leave no gaps
+     @param keep nonzero for each slot to keep
+     @param positions receives each kept slot's index among the kept slots. The other slots are left alone.
+     @param count the number of slots
+     @return the number kept
+     */
+    static inline pos_t PackedPositions(const uint8_t* keep, pos_t* positions, size_t count){
+        pos_t kept = 0;
+        for(size_t slot = 0; slot < count; slot++){
+            if (keep[slot]){
+                positions[slot] = kept++;
+            }
+        }
+        return kept;
+    }
+};
+
+}
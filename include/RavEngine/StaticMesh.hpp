@@ -13,6 +13,8 @@ namespace RavEngine {
         StaticMesh(entity_t owner, Ref<MeshAsset> m) : ComponentWithOwner(owner){
             std::get<0>(tuple) = m;
         }
+        // the renderer keeps StaticMeshes grouped between frames, and only regroups the ones marked changed
+        void QueueRegroup() const;
     public:
 
         StaticMesh(entity_t owner, Ref<MeshAsset> m, Ref<PBRMaterialInstance> mat) : StaticMesh(owner, m) {
@@ -30,8 +32,18 @@ namespace RavEngine {
         */
 		inline void SetMaterial(Ref<PBRMaterialInstance> mat){
 			std::get<1>(tuple) = mat;
+            QueueRegroup();
 		}
 
+        /**
+        Show or hide this staticmesh. Writing Enabled directly also hides it, but it keeps its place in its batch
+        and is skipped each frame, while this removes it from the batch until it is shown again.
+        */
+        inline void SetEnabled(bool enabled){
+            Enabled = enabled;
+            QueueRegroup();
+        }
+
         /**
         @returns the currently assigned material
         */
@@ -29,6 +29,7 @@ public:
 	}
 	
 	void Bind(int id, const SamplerUniform& uniform);
+	void Bind(bgfx::Encoder* encoder, int id, const SamplerUniform& uniform);
     
     /**
      Use the manager to avoid loading duplicate textures
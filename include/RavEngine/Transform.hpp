@@ -17,21 +17,39 @@
 
 namespace RavEngine {
 	struct Transform : public ComponentWithOwner, public Queryable<Transform> {
+        friend class TransformHierarchy;
     protected:
         mutable matrix4 matrix;
-        quaternion rotation;
-        vector3 position, scale;
+        quaternion rotation, worldRotation = quaternion(1.0, 0.0, 0.0, 0.0);
+        vector3 position, scale, worldPosition = vector3(0, 0, 0);     // world values are cached alongside matrix
         UnorderedVector<ComponentHandle<Transform>>  children;        //non-owning
         ComponentHandle<Transform> parent;    //non-owning
-        mutable bool isDirty = false;
+        CopyableAtomic<bool> isDirty = false;     // changed since the World last recalculated matrices
         
-        inline void MarkAsDirty(Transform* root) const{
-            root->isDirty = true;
-            
-            for(auto& t : root->children){
-                MarkAsDirty(t.get());
+        /**
+         Flag this Transform as changed. Only the first change since the last update is queued with the World,
+         which marks children when it recalculates matrices, so repeated changes do not walk the subtree.
+         Safe to call from parallel Systems.
+         */
+        inline void MarkAsDirty(){
+            if (!isDirty.exchange(true)){
+                QueueChange();
             }
         }
+        void QueueChange() const;
+        
+        // true if a parent has been changed since matrices were last recalculated
+        inline bool HasDirtyParent() const{
+            for(auto p = parent; p.IsValid(); p = p->parent){
+                if (p->isDirty){
+                    return true;
+                }
+            }
+            return false;
+        }
+        
+        // true if the cached world values are out of date. Parents are only walked if something in the World changed.
+        bool CacheIsStale() const;
 
 	public:
 		virtual ~Transform(){}
@@ -82,8 +100,9 @@ namespace RavEngine {
 		matrix4 GetMatrix() const;
 
 		/**
-		Get the matrix list of all the parents. 
-		@param list the list to add the matrices to
+		Get the world-space matrix of this transform. The World recalculates every Transform once per frame after
+		its Systems run, so this is normally a read of the cached result. If this Transform or a parent changed since then,
+		the matrix is recalculated by walking the parents.
 		*/
 		matrix4 CalculateWorldMatrix() const;
 
@@ -158,7 +177,7 @@ namespace RavEngine {
 	*/
 	inline Transform& Transform::LocalTranslateDelta(const vector3& delta) {
 		//set position value
-		MarkAsDirty(this);
+		MarkAsDirty();
 		position += delta;
         return *this;
 	}
@@ -174,7 +193,7 @@ namespace RavEngine {
 	*/
 	inline Transform& Transform::SetLocalPosition(const vector3& newPos) {
 		//set position value
-		MarkAsDirty(this);
+		MarkAsDirty();
 		position = newPos;
         return *this;
 	}
@@ -203,7 +222,7 @@ namespace RavEngine {
 	@param newRot the new rotation to set
 	*/
 	inline Transform& Transform::SetLocalRotation(const quaternion& newRot) {
-		MarkAsDirty(this);
+		MarkAsDirty();
 		rotation = newRot;
         return *this;
 	}
@@ -213,7 +232,7 @@ namespace RavEngine {
 	@param delta the change in rotation to apply
 	*/
 	inline Transform& Transform::LocalRotateDelta(const quaternion& delta) {
-		MarkAsDirty(this);
+		MarkAsDirty();
 		//sum two quaternions by multiplying them
 		quaternion finalrot;
 		vector3 t;
@@ -247,13 +266,13 @@ namespace RavEngine {
 	@param newScale the new size of this object in local (parent) space
 	*/
 	inline Transform& Transform::SetLocalScale(const vector3& newScale) {
-		MarkAsDirty(this);
+		MarkAsDirty();
 		scale = newScale;
         return *this;
 	}
 
 	inline Transform& Transform::LocalScaleDelta(const vector3& delta) {
-		MarkAsDirty(this);
+		MarkAsDirty();
 		scale += delta;
         return *this;
 	}
@@ -274,7 +293,8 @@ namespace RavEngine {
 	}
 
 	inline matrix4 Transform::CalculateWorldMatrix() const{
-		if (isDirty){
+		if (CacheIsStale()){
+			// not cached, because the World's update has not reached this change yet
 			//figure out the size
 			unsigned short depth = 0;
             for(auto p = parent; p.IsValid(); p = p->parent){
@@ -294,8 +314,6 @@ namespace RavEngine {
 				mat *= transforms[i];
 			}
 			mat *= GenerateLocalMatrix();
-			matrix = mat;
-			isDirty = false;
 			return mat;
 		}
 		else{
@@ -316,6 +334,9 @@ namespace RavEngine {
 		if (!HasParent()) {
 			return GetLocalPosition();
 		}
+		if (!CacheIsStale()){
+			return worldPosition;
+		}
 		auto finalMatrix = CalculateWorldMatrix();
 		
 		//finally apply the local matrix
@@ -327,16 +348,15 @@ namespace RavEngine {
 		if (!HasParent()) {
 			return GetLocalRotation();
 		}
+		if (!CacheIsStale()){
+			return worldRotation;
+		}
 		
-		//apply local rotation
-		auto finalMatrix = CalculateWorldMatrix();
-		
-		//decompose the matrix to extract the rotation
-		quaternion finalrot;
-		
-		vector3 t;
-		vector4 p;
-		glm::decompose(finalMatrix, t, finalrot, t, t, p);
+		//combine the rotations of the parents, the same way the World's update does
+		quaternion finalrot = GetLocalRotation();
+		for(auto p = parent; p.IsValid(); p = p->parent){
+			finalrot = p->GetLocalRotation() * finalrot;
+		}
 		return finalrot;
 	}
 }
@@ -0,0 +1,118 @@
+#pragma once
+#include "DataStructures.hpp"
+#include "mathtypes.hpp"
+#include "Types.hpp"
+#include <array>
+#include <atomic>
+
+namespace RavEngine{
+struct Transform;
+
+/**
+ Local positions, rotations and scales stored as one array per component, padded to a multiple of
+ simd_width with identity values so that the SIMD kernel can always load whole batches.
+ */
+struct TransformSoA{
+    constexpr static size_t simd_width = 4;
+    std::array<Vector<float>, 3> positions;
+    std::array<Vector<float>, 4> rotations;
+    std::array<Vector<float>, 3> scales;
+
+    void resize(size_t count);
+
+    inline void Set(size_t idx, const vector3& position, const quaternion& rotation, const vector3& scale){
+        for(int c = 0; c < 3; c++){
+            positions[c][idx] = position[c];
+            scales[c][idx] = scale[c];
+        }
+        rotations[0][idx] = rotation.x;
+        rotations[1][idx] = rotation.y;
+        rotations[2][idx] = rotation.z;
+        rotations[3][idx] = rotation.w;
+    }
+};
+
+/**
+ Compute translate * rotate * scale for each transform in [begin, end), simd_width at a time
+ @param soa the local values
+ @param begin the first index, which must be a multiple of TransformSoA::simd_width
+ @param end one past the last index
+ @param out the matrices, indexed the same as soa
+ */
+void ComputeLocalMatrices(const TransformSoA& soa, size_t begin, size_t end, matrix4* out);
+
+/**
+ The same as ComputeLocalMatrices, one transform at a time with glm
+ */
+void ComputeLocalMatricesScalar(const TransformSoA& soa, size_t begin, size_t end, matrix4* out);
+
+/**
+ Computes the world matrices of every Transform in a World once per frame.
+ Transforms queue themselves the first time they change after an update, and their children are marked
+ from the hierarchy order during the update instead of when each change is made.
+ Local positions, rotations and scales are mirrored into arrays sorted by hierarchy depth, so that every
+ parent is computed before its children in a single pass without walking parent handles. Local matrices
+ are computed in SIMD batches, which for root Transforms are also their world matrices. The results are
+ written back to each Transform's cached matrix, world position and world rotation.
+ */
+class TransformHierarchy{
+    constexpr static uint32_t no_parent = std::numeric_limits<uint32_t>::max();
+    constexpr static uint32_t external_parent = no_parent - 1;   // parented to a Transform in another World
+
+    // one entry per node, sorted so parents come before their children
+    TransformSoA locals;
+    Vector<matrix4> worldMatrices;
+    Vector<quaternion> worldRotations;
+    Vector<uint32_t> parents;       // node index of the parent, no_parent or external_parent
+    Vector<entity_t> parentOwners;  // to detect reparenting
+    Vector<uint8_t> dirty, dirtyBatches;
+    Vector<Transform*> transforms;
+    UnorderedMap<entity_t, uint32_t> nodeOfOwner;
+    ConcurrentQueue<entity_t> changed;
+    std::atomic<uint32_t> pendingChanges = 0;
+    Vector<entity_t> changedBatch;
+    Vector<entity_t> moved;
+
+    const Transform* data = nullptr;
+    size_t count = 0, generation = 0;
+
+    void Rebuild(Transform* data, size_t count);
+
+public:
+    /**
+     Queue a changed Transform for the next update. Safe to call from any thread.
+     @param owner the global id of the Transform's owner
+     */
+    inline void MarkChanged(entity_t owner){
+        changed.enqueue(owner);
+        pendingChanges.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     @return true if a Transform has changed since the last update, so cached values may be out of date
+     */
+    inline bool HasPendingChanges() const{
+        return pendingChanges.load(std::memory_order_relaxed) > 0;
+    }
+
+    /**
+     Recalculate the world matrix of every dirty Transform
+     @param data the Transforms in the World, which must stay in place until the next call
+     @param count the number of Transforms
+     @param generation the storage's generation, which changes when Transforms are added or removed
+     */
+    void Update(Transform* data, size_t count, size_t generation);
+
+    /**
+     @return the global ids of the owners of the Transforms whose world matrix was recalculated by the last update
+     */
+    inline const Vector<entity_t>& GetMoved() const{
+        return moved;
+    }
+
+    inline size_t size() const{
+        return transforms.size();
+    }
+};
+
+}
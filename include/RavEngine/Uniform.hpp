@@ -29,6 +29,17 @@ public:
     constexpr inline void SetValues(T* value, int numValues){
 		bgfx::setUniform(handle, value, numValues);
 	}
+	
+	/**
+	 Set the values in a uniform for the next draw recorded by an encoder
+	 @param encoder the encoder to record to
+	 @param value the pointer to the beginning of the array of values
+	 @param numValues the number of values in the array
+	 */
+	template<typename T>
+	inline void SetValues(bgfx::Encoder* encoder, T* value, int numValues){
+		encoder->setUniform(handle, value, numValues);
+	}
     
 	/**
 	 * @return true if this uniform is valid and therefore safe to use
@@ -18,6 +18,16 @@
 #include "Types.hpp"
 #include "AddRemoveAction.hpp"
 #include "PolymorphicIndirection.hpp"
+#include "ArchetypeStorage.hpp"
+#include "PagedSparseArray.hpp"
+#include "BVH.hpp"
+#include "LightCulling.hpp"
+#include "ExecutionPolicy.hpp"
+#include "StaticBatches.hpp"
+#include "TransformHierarchy.hpp"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace RavEngine {
 	class Entity;
@@ -38,13 +48,13 @@ namespace RavEngine {
     constexpr std::size_t Index_v = Index<T, Ts...>::value;
 
     template <typename T>
-    class HasDestroy
+    class HasQueryTypes
     {
     private:
         typedef char YesType[1];
         typedef char NoType[2];
 
-        template <typename C> static YesType& test( decltype(&C::Destroy) ) ;
+        template <typename C> static YesType& test( decltype(&C::GetQueryTypes) ) ;
         template <typename C> static NoType& test(...);
 
 
@@ -52,19 +62,82 @@ namespace RavEngine {
         enum { value = sizeof(test<T>(0)) == sizeof(YesType) };
     };
 
-    template <typename T>
-    class HasQueryTypes
-    {
-    private:
-        typedef char YesType[1];
-        typedef char NoType[2];
+    /**
+     Wrap a component type in EmplaceSystem to visit only the components of that type that were added, or passed to
+     MarkChanged, since the System last ran. Transforms mark themselves when they are moved. Outside a System, use
+     World::FilterChanged, which takes the caller's own cursor. Chunked components do not track changes.
+     */
+    template<typename T>
+    struct Changed{
+        using type = T;
+    };
 
-        template <typename C> static YesType& test( decltype(&C::GetQueryTypes) ) ;
-        template <typename C> static NoType& test(...);
+    template<typename T>
+    static constexpr bool IsChanged = false;
 
+    template<typename T>
+    static constexpr bool IsChanged<Changed<T>> = true;
 
-    public:
-        enum { value = sizeof(test<T>(0)) == sizeof(YesType) };
+    template<typename T>
+    struct StripChanged{
+        using type = T;
+    };
+
+    template<typename T>
+    struct StripChanged<Changed<T>>{
+        using type = T;
+    };
+
+    template<typename T>
+    using StripChanged_t = typename StripChanged<T>::type;
+
+    // the parameter list of a System's call operator, if it has exactly one
+    template<typename F>
+    struct SystemSignature{
+        constexpr static bool known = false;
+    };
+
+    template<typename C, typename R, typename ... P>
+    struct SystemSignature<R(C::*)(P...)>{
+        constexpr static bool known = true;
+        using params = std::tuple<P...>;
+    };
+
+    template<typename C, typename R, typename ... P>
+    struct SystemSignature<R(C::*)(P...) const> : public SystemSignature<R(C::*)(P...)>{};
+
+    template<typename T, typename = void>
+    struct SystemCallOperator{
+        using type = void;  // templated or overloaded operator(), cannot be inspected
+    };
+
+    template<typename T>
+    struct SystemCallOperator<T, std::void_t<decltype(&T::operator())>>{
+        using type = decltype(&T::operator());
+    };
+
+    /**
+     Determines whether a System only reads a component type, from the matching parameter of its operator().
+     A System receives (float fpsScale, A&...), so the parameter for A[i] is at index i + 1. A const reference or
+     a by-value parameter is a read. Anything that cannot be inspected counts as a write.
+     */
+    template<typename T, typename ... A>
+    struct SystemAccess{
+        using signature = SystemSignature<typename SystemCallOperator<T>::type>;
+
+        template<size_t i>
+        constexpr static bool IsReadOnly(){
+            if constexpr (!signature::known){
+                return false;
+            }
+            else if constexpr (std::tuple_size_v<typename signature::params> != sizeof...(A) + 1){
+                return false;
+            }
+            else{
+                using param_t = std::tuple_element_t<i + 1, typename signature::params>;
+                return !std::is_reference_v<param_t> || std::is_const_v<std::remove_reference_t<param_t>>;
+            }
+        }
     };
 
 	class World {
@@ -76,12 +149,26 @@ namespace RavEngine {
         
         friend class Entity;
         friend class Registry;
+        friend struct Transform;
     public:
         template<typename T>
         class SparseSet{
             unordered_vector<T> dense_set;
             UnorderedVector<entity_t> aux_set;
-            Vector<entity_t> sparse_set{INVALID_ENTITY};
+            // a change version that workers can stamp concurrently. Copies only happen when the set is resized, which is not concurrent.
+            struct ChangeStamp{
+                std::atomic<uint64_t> value;
+                ChangeStamp(uint64_t value) : value(value){}
+                ChangeStamp(const ChangeStamp& other) noexcept : value(other.value.load(std::memory_order_relaxed)){}
+                ChangeStamp& operator=(const ChangeStamp& other) noexcept{
+                    value.store(other.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    return *this;
+                }
+            };
+            UnorderedVector<ChangeStamp> versions;     // the change version of each dense element
+            PagedSparseArray<entity_t, INVALID_ENTITY> sparse_set;
+            std::atomic<uint64_t> changeVersion = 1;
+            size_t generation = 0;      // changes whenever elements are added or removed
             
         public:
             
@@ -91,41 +178,71 @@ namespace RavEngine {
             inline T& Emplace(entity_t local_id, A ... args){
                 auto& ret = dense_set.emplace(args...);
                 aux_set.emplace(local_id);
-                if (local_id >= sparse_set.size()){
-                    sparse_set.resize(closest_multiple_of(local_id+1,2),INVALID_ENTITY);  //ensure there is enough space for this id
-                }
-                
-				sparse_set[local_id] = static_cast<typename decltype(sparse_set)::value_type>(dense_set.size()-1);
+                versions.emplace(changeVersion.load(std::memory_order_relaxed));
+				sparse_set.set(local_id, static_cast<entity_t>(dense_set.size()-1));
+                generation++;
                 return ret;
             }
             
+            // make room for count more components, on entities with ids up to max_local_id
+            inline void Reserve(size_t count, entity_t max_local_id){
+                dense_set.reserve(dense_set.size() + count);
+                aux_set.reserve(aux_set.size() + count);
+                versions.reserve(versions.size() + count);
+                sparse_set.reserve(max_local_id);
+            }
+            
             inline void Destroy(entity_t local_id){
-                assert(local_id < sparse_set.size());
                 assert(HasComponent(local_id)); // Cannot destroy a component on an entity that does not have one!
                 // call the destructor
                 if constexpr(HasDestroy<T>::value){
                     auto& oldvalue = GetComponent(local_id);
                     oldvalue.Destroy();
                 }
-                dense_set.erase(dense_set.begin() + sparse_set[local_id]);
-                aux_set.erase(aux_set.begin() + sparse_set[local_id]);
+                auto denseidx = sparse_set.get(local_id);
+                dense_set.erase(dense_set.begin() + denseidx);
+                aux_set.erase(aux_set.begin() + denseidx);
+                versions.erase(versions.begin() + denseidx);
 
-                if (sparse_set[local_id] < aux_set.size()) {    // did a move happen during this deletion?
+                if (denseidx < aux_set.size()) {    // did a move happen during this deletion?
                     // update the location it points
-                    auto owner = aux_set[sparse_set[local_id]];
-                    sparse_set[owner] = sparse_set[local_id];
+                    auto owner = aux_set[denseidx];
+                    sparse_set.set(owner, denseidx);
                     
                 }
-                sparse_set[local_id] = INVALID_INDEX;
+                sparse_set.erase(local_id);
+                generation++;
             }
 
             inline T& GetComponent(entity_t local_id){
                 assert(HasComponent(local_id));
-                return dense_set[sparse_set[local_id]];
+                return dense_set[sparse_set.get(local_id)];
             }
             
             inline auto SparseToDense(entity_t local_id){
-                return sparse_set[local_id];
+                return sparse_set.get(local_id);
+            }
+            
+            // record that a component was modified, so that the next change scan visits it. Safe to call from parallel Systems.
+            inline void MarkChanged(entity_t local_id){
+                assert(HasComponent(local_id));
+                versions[sparse_set.get(local_id)].value.store(changeVersion.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            
+            /**
+             Start a scan for changed components
+             @param cursor the version the caller last scanned at, which is advanced to now
+             @return the version to pass to ChangedSince. Changes made during the scan are picked up by the next one.
+             */
+            inline uint64_t BeginChangeScan(uint64_t& cursor){
+                auto since = cursor;
+                cursor = changeVersion.fetch_add(1, std::memory_order_relaxed);
+                return since;
+            }
+            
+            // by dense index
+            inline bool ChangedSince(entity_t idx, uint64_t since) const{
+                return versions[idx].value.load(std::memory_order_relaxed) > since;
             }
             
             inline T& GetFirst(){
@@ -134,7 +251,12 @@ namespace RavEngine {
             }
             
             inline bool HasComponent(entity_t local_id) const{
-                return local_id < sparse_set.size() && sparse_set[local_id] != INVALID_ENTITY;
+                return sparse_set.contains(local_id);
+            }
+            
+            // bytes used to map entity ids to dense indices
+            inline size_t SparseMemoryUsage() const{
+                return sparse_set.memory_usage();
             }
             
             auto begin(){
@@ -170,6 +292,11 @@ namespace RavEngine {
                 return dense_set.data();
             }
             
+            // pointers into the dense set remain valid while this is unchanged
+            inline size_t Generation() const{
+                return generation;
+            }
+            
             inline const decltype(dense_set)& GetDense() const{
                 return dense_set;
             }
@@ -178,47 +305,137 @@ namespace RavEngine {
         struct SparseSetErased{
             constexpr static size_t buf_size = sizeof(SparseSet<size_t>);   // we use size_t here because all SparseSets are the same size
             std::array<char, buf_size> buffer;
-            std::function<void(entity_t id,World*)> destroyFn;
-            std::function<void(void)> deallocFn;
-            std::function<void(entity_t, entity_t, World*)> moveFn;
             
-            template<typename T>
-            inline SparseSet<T>* GetSet() {
-                return reinterpret_cast<SparseSet<T>*>(buffer.data());
-            }
+            struct VTable{
+                void(*destroyFn)(SparseSetErased*, entity_t id, World*);
+                void(*deallocFn)(SparseSetErased*);
+                void(*moveFn)(SparseSetErased*, entity_t, entity_t, World*);
+            };
             
-            // the discard parameter is here to make the template work
             template<typename T>
-            SparseSetErased(T* discard) :
-                destroyFn([&](entity_t local_id, World* wptr){
-                    auto ptr = GetSet<T>();
-                    if (ptr->HasComponent(local_id)){
+            struct VTableFor{
+                static void Destroy(SparseSetErased* self, entity_t local_id, World* wptr){
+                    if (self->template GetSet<T>()->HasComponent(local_id)){
                         wptr->DestroyComponent<T>(local_id);
                     }
-                }),
-                deallocFn([&]() {
-                    GetSet<T>()->~SparseSet<T>();
-                }),
-                moveFn([&](entity_t localID, entity_t otherLocalID, World* otherWorld){
-                    auto sp = GetSet<T>();
+                }
+                
+                static void Dealloc(SparseSetErased* self){
+                    self->template GetSet<T>()->~SparseSet<T>();
+                }
+                
+                static void Move(SparseSetErased* self, entity_t localID, entity_t otherLocalID, World* otherWorld){
+                    auto sp = self->template GetSet<T>();
                     if (sp->HasComponent(localID)){
                         auto& comp = sp->GetComponent(localID);
                         otherWorld->EmplaceComponent<T>(otherLocalID, std::move(comp));
                         // then delete it from here
                         sp->Destroy(localID);
                     }
-                })
+                }
+                
+                static constexpr VTable value{&Destroy, &Dealloc, &Move};
+            };
+            
+            const VTable* vtable;
+            
+            template<typename T>
+            inline SparseSet<T>* GetSet() {
+                return reinterpret_cast<SparseSet<T>*>(buffer.data());
+            }
+            
+            // the discard parameter is here to make the template work
+            template<typename T>
+            SparseSetErased(T* discard) : vtable(&VTableFor<T>::value)
             {
                 static_assert(sizeof(SparseSet<T>) <= buf_size);
                 new (buffer.data()) SparseSet<T>();
             }
 
             ~SparseSetErased() {
-                deallocFn();
+                vtable->deallocFn(this);
             }
         };
         
 		locked_node_hashmap<RavEngine::ctti_t, SparseSetErased,SpinLock> componentMap;
+        
+        // the most component types a process can use, so that componentSets never reallocates while other threads read it
+        constexpr static uint32_t max_component_types = 1024;
+        // indexed by ComponentTypeIndex, which is also the type's bit in the component masks. Only written under componentSetsMtx.
+        std::array<std::atomic<SparseSetErased*>, max_component_types> componentSets{};
+        SpinLock componentSetsMtx;
+        
+        // maskWords words per local entity, so that destroying or moving an entity only visits the types it has.
+        // Widened under componentSetsMtx when a new type needs a bit.
+        Vector<uint64_t> componentMasks;
+        uint32_t maskWords = 1;
+        
+        inline void SetComponentBit(entity_t local_id, uint32_t bit){
+            auto required = (size_t(local_id) + 1) * maskWords;
+            if (componentMasks.size() < required){
+                componentMasks.resize(std::max(required, componentMasks.size() * 2), 0);
+            }
+            componentMasks[local_id * maskWords + bit / 64] |= (uint64_t(1) << (bit % 64));
+        }
+        
+        inline void ClearComponentBit(entity_t local_id, uint32_t bit){
+            auto word = size_t(local_id) * maskWords + bit / 64;
+            if (word < componentMasks.size()){
+                componentMasks[word] &= ~(uint64_t(1) << (bit % 64));
+            }
+        }
+        
+        inline void ClearComponentBits(entity_t local_id){
+            auto begin = size_t(local_id) * maskWords;
+            for(size_t i = begin; i < std::min(begin + maskWords, componentMasks.size()); i++){
+                componentMasks[i] = 0;
+            }
+        }
+        
+        // invoke fn with the SparseSetErased of every type on the entity. The mask may be modified by fn.
+        template<typename func_t>
+        inline void ForEachComponentSet(entity_t local_id, const func_t& fn){
+            for(uint32_t w = 0; w < maskWords; w++){
+                auto word = size_t(local_id) * maskWords + w;
+                if (word >= componentMasks.size()){
+                    break;
+                }
+                auto bits = componentMasks[word];
+                while (bits != 0){
+                    auto bit = static_cast<uint32_t>(CountTrailingZeros(bits));
+                    bits &= bits - 1;
+                    fn(*componentSets[w * 64 + bit].load(std::memory_order_relaxed));
+                }
+            }
+        }
+        
+        static inline uint32_t CountTrailingZeros(uint64_t value){
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward64(&index, value);
+            return index;
+#else
+            return __builtin_ctzll(value);
+#endif
+        }
+        
+        // record a new type's set, widening every entity's mask if its bit does not fit. Call with componentSetsMtx held.
+        inline void RegisterComponentSet(SparseSetErased& set, uint32_t typeIndex){
+            assert(typeIndex < max_component_types);
+            if (typeIndex >= maskWords * 64){
+                auto newWords = typeIndex / 64 + 1;
+                auto n_entities = componentMasks.size() / maskWords;
+                Vector<uint64_t> widened(n_entities * newWords, 0);
+                for(size_t e = 0; e < n_entities; e++){
+                    std::copy(componentMasks.begin() + e * maskWords, componentMasks.begin() + (e + 1) * maskWords, widened.begin() + e * newWords);
+                }
+                componentMasks = std::move(widened);
+                maskWords = newWords;
+            }
+            // publish last, so that a thread that finds the set also sees it constructed
+            componentSets[typeIndex].store(&set, std::memory_order_release);
+        }
+        ArchetypeStorage chunkedComponents;
     public:
         struct PolymorphicIndirection{
             struct elt{
@@ -226,7 +443,7 @@ namespace RavEngine {
                 ctti_t full_id = 0;
                 template<typename T>
                 elt(World* world, T* discard) : full_id(CTTI<T>()){
-                    auto setptr = world->componentMap.at(CTTI<T>()).template GetSet<T>();
+                    auto setptr = world->GetSetErased<T>()->template GetSet<T>();
                     getfn = [setptr](entity_t local_id) -> void*{
                         auto& thevalue = setptr->GetComponent(local_id);
                         return &(thevalue);
@@ -308,7 +525,7 @@ namespace RavEngine {
         class SparseSetForPolymorphic{
             using U = PolymorphicIndirection;
             unordered_vector<U> dense_set;
-            Vector<entity_t> sparse_set{INVALID_ENTITY};
+            PagedSparseArray<entity_t, INVALID_ENTITY> sparse_set;
             
         public:
             
@@ -319,10 +536,7 @@ namespace RavEngine {
                 //if a record for this does not exist, create it
                 if (!HasForEntity(local_id)){
                     dense_set.emplace(local_id,world);
-                    if (local_id >= sparse_set.size()){
-                        sparse_set.resize(closest_multiple_of(local_id+1,2),INVALID_ENTITY);  //ensure there is enough space for this id
-                    }
-                    sparse_set[local_id] = static_cast<decltype(sparse_set)::value_type>(dense_set.size()-1);
+                    sparse_set.set(local_id, static_cast<entity_t>(dense_set.size()-1));
                 }
                 
                 // then push the Elt into it
@@ -337,24 +551,24 @@ namespace RavEngine {
                     
                 // if that makes the container empty, then delete it from the Sets
                if (GetForEntity(local_id).empty()){
-                   auto denseidx = sparse_set[local_id];
+                   auto denseidx = sparse_set.get(local_id);
                    dense_set.erase(dense_set.begin() + denseidx);
 
                    if (denseidx < dense_set.size()) {    // did a move happen during this deletion?
                        auto ownerOfMoved = dense_set[denseidx].owner;
-                       sparse_set[ownerOfMoved] = denseidx;
+                       sparse_set.set(ownerOfMoved, denseidx);
                    }
-                   sparse_set[local_id] = INVALID_INDEX;
+                   sparse_set.erase(local_id);
                }
             }
 
             inline U& GetForEntity(entity_t local_id){
                 assert(HasForEntity(local_id));
-                return dense_set[sparse_set[local_id]];
+                return dense_set[sparse_set.get(local_id)];
             }
 
             inline auto SparseToDense(entity_t local_id){
-                return sparse_set[local_id];
+                return sparse_set.get(local_id);
             }
 
             inline entity_t GetOwnerForDenseIdx(entity_t dense_idx) {
@@ -365,7 +579,7 @@ namespace RavEngine {
 
             
             inline bool HasForEntity(entity_t local_id) const{
-                return local_id < sparse_set.size() && sparse_set[local_id] != INVALID_ENTITY;
+                return sparse_set.contains(local_id);
             }
             
             auto begin(){
@@ -403,27 +617,170 @@ namespace RavEngine {
         };
         
         UnorderedNodeMap<ctti_t,SparseSetForPolymorphic> polymorphicQueryMap;
+        
+        /**
+         A persistent list of every entity that has all of a set of component types.
+         Groups are kept up to date as components are added and removed, so queries
+         over multiple types iterate only matching entities instead of checking each one.
+         */
+        struct QueryGroup{
+            Vector<entity_t> entities;          // packed local ids of the matching entities
+            PagedSparseArray<pos_t, INVALID_INDEX> sparse_set;   // local id -> index into entities
+            Function<bool(entity_t)> matches;
+            
+            inline bool Contains(entity_t local_id) const{
+                return sparse_set.contains(local_id);
+            }
+            
+            inline void Add(entity_t local_id){
+                if (Contains(local_id)){
+                    return;
+                }
+                sparse_set.set(local_id, static_cast<pos_t>(entities.size()));
+                entities.push_back(local_id);
+            }
+            
+            inline void Remove(entity_t local_id){
+                if (!Contains(local_id)){
+                    return;
+                }
+                // swap the last entity into the hole
+                auto idx = sparse_set.get(local_id);
+                auto last = entities.back();
+                entities[idx] = last;
+                sparse_set.set(last, idx);
+                entities.pop_back();
+                sparse_set.erase(local_id);
+            }
+        };
+        
+        /**
+         The sorted type ids of a QueryGroup, so that the same types listed in any order find the same group.
+         The ids themselves are compared, so sets of types whose hashes collide still get separate groups.
+         */
+        struct QueryGroupKey{
+            SmallVector<ctti_t, 4> types;
+            size_t hash = 0;
+            
+            inline bool operator==(const QueryGroupKey& other) const{
+                return hash == other.hash && types == other.types;
+            }
+            
+            struct Hasher{
+                inline size_t operator()(const QueryGroupKey& key) const{
+                    return key.hash;    // hash is precomputed
+                }
+            };
+        };
+        phmap::node_hash_map<QueryGroupKey, QueryGroup, QueryGroupKey::Hasher> queryGroups;
+        UnorderedMap<ctti_t, Vector<QueryGroup*>> typeToQueryGroups;
+        SpinLock queryGroupsMtx;    // so that Filters in parallel tasks can create groups
+        
+        template<typename ... A>
+        inline QueryGroup* GetQueryGroup(){
+            QueryGroupKey key{{CTTI<A>()...}, 0};
+            std::sort(key.types.begin(), key.types.end());
+            for(const auto id : key.types){
+                key.hash ^= id + 0x9e3779b9 + (key.hash << 6) + (key.hash >> 2);
+            }
+            
+            std::lock_guard<SpinLock> lock(queryGroupsMtx);
+            auto result = queryGroups.try_emplace(std::move(key));
+            auto group = &(*result.first).second;
+            if (result.second){
+                group->matches = [sets = std::make_tuple(MakeIfNotExists<A>()...)](entity_t local_id){
+                    return (std::get<SparseSet<A>*>(sets)->HasComponent(local_id) && ...);
+                };
+                // populate with the entities that already match
+                using primary_t = typename std::tuple_element<0, std::tuple<A...> >::type;
+                auto primary = MakeIfNotExists<primary_t>();
+                for(entity_t i = 0; i < primary->DenseSize(); i++){
+                    auto owner = primary->GetOwner(i);
+                    if (group->matches(owner)){
+                        group->Add(owner);
+                    }
+                }
+                for(const auto id : (*result.first).first.types){
+                    typeToQueryGroups[id].push_back(group);
+                }
+            }
+            return group;
+        }
+        
+        inline void QueryGroupsOnAdd(ctti_t type, entity_t local_id){
+            auto it = typeToQueryGroups.find(type);
+            if (it != typeToQueryGroups.end()){
+                for(auto group : (*it).second){
+                    if (group->matches(local_id)){
+                        group->Add(local_id);
+                    }
+                }
+            }
+        }
+        
+        inline void QueryGroupsOnRemove(ctti_t type, entity_t local_id){
+            auto it = typeToQueryGroups.find(type);
+            if (it != typeToQueryGroups.end()){
+                for(auto group : (*it).second){
+                    group->Remove(local_id);
+                }
+            }
+        }
 
         inline void DestroyEntity(entity_t local_id){
             // go down the list of all component types registered in this world
             // and call destroy if the entity has that component type
             // possible optimization: vector of vector<ctti_t> to make this faster?
             NetworkingDestroy(local_id);
-            for(const auto& pair : componentMap){
-                pair.second.destroyFn(local_id,this);
-            }
+            chunkedComponents.DestroyEntity(local_id);
+            ForEachComponentSet(local_id, [&](SparseSetErased& set){
+                set.vtable->destroyFn(&set,local_id,this);
+            });
             // unset localToGlobal
             available.push(local_id);
             localToGlobal[local_id] = INVALID_ENTITY;
         }
         
+        // nullptr if no component of this type has been created in this world
+        template<typename T>
+        inline SparseSetErased* GetSetErased() const{
+            const auto idx = ComponentTypeIndex<T>();
+            return idx < max_component_types ? componentSets[idx].load(std::memory_order_acquire) : nullptr;
+        }
+        
+        // safe to call from several threads at once, such as from Filters in parallel tasks
         template<typename T>
         inline SparseSet<T>* MakeIfNotExists(){
-            return (*componentMap.try_emplace(RavEngine::CTTI<T>(),static_cast<T*>(nullptr)).first).second.template GetSet<T>();
+            if (auto erased = GetSetErased<T>()){
+                return erased->template GetSet<T>();
+            }
+            std::lock_guard<SpinLock> lock(componentSetsMtx);
+            auto result = componentMap.try_emplace(RavEngine::CTTI<T>(),static_cast<T*>(nullptr));
+            auto& set = (*result.first).second;
+            if (result.second){
+                RegisterComponentSet(set, ComponentTypeIndex<T>());
+            }
+            return set.template GetSet<T>();
         }
         
         template<typename T, typename ... A>
         inline T& EmplaceComponent(entity_t local_id, A ... args){
+            if constexpr (IsChunked<T>){
+                static_assert(!HasQueryTypes<T>::value, "Chunked components cannot be Queryable");
+                if constexpr(std::is_constructible<T,entity_t, A...>::value || (sizeof ... (A) == 0 && std::is_constructible<T,entity_t>::value)){
+                    return chunkedComponents.Emplace<T>(local_id, localToGlobal[local_id], args...);
+                }
+                else{
+                    return chunkedComponents.Emplace<T>(local_id, args...);
+                }
+            }
+            else{
+                return EmplaceSparseComponent<T>(local_id, args...);
+            }
+        }
+        
+        template<typename T, typename ... A>
+        inline T& EmplaceSparseComponent(entity_t local_id, A ... args){
             auto ptr = MakeIfNotExists<T>();
             //constexpr bool isMoving = sizeof ... (A) == 1; && (std::is_rvalue_reference<typename std::tuple_element<0, std::tuple<A...>>::type>::value || std::is_lvalue_reference<typename std::tuple_element<0, std::tuple<A...>>::type>::value);
                         
@@ -437,17 +794,38 @@ namespace RavEngine {
             }
             
             //detect if T constructor's first argument is an entity_t, if it is, then we need to pass that before args (pass local_id again)
+            T* ret;
             if constexpr(std::is_constructible<T,entity_t, A...>::value || (sizeof ... (A) == 0 && std::is_constructible<T,entity_t>::value)){
-                return ptr->Emplace(local_id, localToGlobal[local_id], args...);
+                ret = &ptr->Emplace(local_id, localToGlobal[local_id], args...);
             }
             else{
-                return ptr->Emplace(local_id,args...);
+                ret = &ptr->Emplace(local_id,args...);
             }
+            SetComponentBit(local_id, ComponentTypeIndex<T>());
+            QueryGroupsOnAdd(CTTI<T>(), local_id);
+            return *ret;
         }
 
         template<typename T>
         inline T& GetComponent(entity_t local_id) {
-            return componentMap.at(RavEngine::CTTI<T>()).template GetSet<T>()->GetComponent(local_id);
+            if constexpr (IsChunked<T>){
+                return chunkedComponents.Get<T>(local_id);
+            }
+            else{
+                assert(GetSetErased<T>() != nullptr);
+                return GetSetErased<T>()->template GetSet<T>()->GetComponent(local_id);
+            }
+        }
+        
+        /**
+         Record that a component was modified, so that Changed<T> queries visit it. Reading a component through
+         GetComponent does not count as a change. Safe to call from parallel Systems.
+         */
+        template<typename T>
+        inline void MarkChanged(entity_t local_id){
+            static_assert(!IsChunked<T>, "Chunked components do not track changes");
+            assert(GetSetErased<T>() != nullptr);
+            GetSetErased<T>()->template GetSet<T>()->MarkChanged(local_id);
         }
         
         template<typename T>
@@ -457,7 +835,13 @@ namespace RavEngine {
 
         template<typename T>
         inline bool HasComponent(entity_t local_id) {
-            return componentMap.at(RavEngine::CTTI<T>()).template GetSet<T>()->HasComponent(local_id);
+            if constexpr (IsChunked<T>){
+                return chunkedComponents.Has<T>(local_id);
+            }
+            else{
+                auto erased = GetSetErased<T>();
+                return erased != nullptr && erased->template GetSet<T>()->HasComponent(local_id);
+            }
         }
         
         template<typename T>
@@ -467,30 +851,37 @@ namespace RavEngine {
         
         template<typename T>
         inline void DestroyComponent(entity_t local_id){
-
-            auto setptr = componentMap.at(RavEngine::CTTI<T>()).template GetSet<T>();
-            // perform special cases
-            if constexpr (RemoveAction<T>::HasCustomAction()){
-                auto& comp = setptr->GetComponent(local_id);
-                RemoveAction<T> obj;
-                obj.DoAction(&comp);
+            if constexpr (IsChunked<T>){
+                chunkedComponents.Destroy<T>(local_id);
             }
-            
-            setptr->Destroy(local_id);
-            // does this component have alternate query types
-            if constexpr (HasQueryTypes<T>::value){
-                // polymorphic recordkeep
-                const auto ids = T::GetQueryTypes();
-                for(const auto id : ids){
-                    polymorphicQueryMap[id].template Destroy<T>(local_id);
+            else{
+                assert(GetSetErased<T>() != nullptr);
+                auto setptr = GetSetErased<T>()->template GetSet<T>();
+                // perform special cases
+                if constexpr (RemoveAction<T>::HasCustomAction()){
+                    auto& comp = setptr->GetComponent(local_id);
+                    RemoveAction<T> obj;
+                    obj.DoAction(&comp);
+                }
+                
+                setptr->Destroy(local_id);
+                ClearComponentBit(local_id, ComponentTypeIndex<T>());
+                QueryGroupsOnRemove(CTTI<T>(), local_id);
+                // does this component have alternate query types
+                if constexpr (HasQueryTypes<T>::value){
+                    // polymorphic recordkeep
+                    const auto ids = T::GetQueryTypes();
+                    for(const auto id : ids){
+                        polymorphicQueryMap[id].template Destroy<T>(local_id);
+                    }
                 }
             }
         }
                 
         template<typename T>
         inline SparseSet<T>* GetRange(){
-            auto& set = componentMap.at(RavEngine::CTTI<T>());
-            return set.template GetSet<T>();
+            assert(GetSetErased<T>() != nullptr);
+            return GetSetErased<T>()->template GetSet<T>();
         }
         
         template<typename T, bool isPolymorphic = false>
@@ -537,6 +928,18 @@ namespace RavEngine {
         
         entity_t CreateEntity();
         
+        template<typename T, typename batch_t>
+        inline void EmplaceBatch(const batch_t& batch){
+            if constexpr (!IsChunked<T>){
+                MakeIfNotExists<T>()->Reserve(batch.count, batch.firstLocal + batch.count - 1);
+            }
+            for(entity_t i = 0; i < batch.count; i++){
+                EmplaceComponent<T>(batch.firstLocal + i);
+            }
+        }
+        
+        void DestroyEntities(const entity_t* global_ids, size_t count);
+        
         template<typename func, bool polymorphic>
         struct FuncMode{
             func& f;
@@ -649,15 +1052,230 @@ namespace RavEngine {
         inline void FilterGeneric(const funcmode_t& fm) {
             auto scale = GetCurrentFPSScale();
             auto fd = GenFilterData<A...>(fm);
-            auto mainFilter = fd.getMainFilter();
-            FilterOneMode fom(fm, fd.ptrs);
-            for (entity_t i = 0; i < mainFilter->DenseSize(); i++) {
-                FilterOne<A...>(fom, i, scale);
+            if constexpr (!funcmode_t::isPolymorphic() && sizeof ... (A) > 1){
+                // every entity in the group has all the types, so no checks are needed
+                auto group = GetQueryGroup<A...>();
+                for (pos_t i = 0; i < group->entities.size(); i++){
+                    auto owner = group->entities[i];
+                    fm.f(scale, FilterComponentGet<A>(owner, fd.ptrs[Index_v<A, A...>])...);
+                }
+            }
+            else{
+                auto mainFilter = fd.getMainFilter();
+                FilterOneMode fom(fm, fd.ptrs);
+                for (entity_t i = 0; i < mainFilter->DenseSize(); i++) {
+                    FilterOne<A...>(fom, i, scale);
+                }
             }
         }
         void NetworkingSpawn(ctti_t,Entity&);
         void NetworkingDestroy(entity_t);
     public:
+        using ExecutionPolicy = RavEngine::ExecutionPolicy;
+    private:
+        using SystemExecutionState = ExecutionState;
+        UnorderedNodeMap<ctti_t, SystemExecutionState> systemExecutionStates;
+        pos_t numWorkers = 1;
+        
+        template<typename body_t>
+        inline void ForEachWithPolicy(tf::Subflow& sf, pos_t n, SystemExecutionState& state, const body_t& body){
+            state.ForEach(sf, n, numWorkers, body);
+        }
+        
+        template<typename T, typename body_t>
+        inline tf::Task EmplaceSystemTask(pos_t* range, const body_t& body){
+            auto state = &systemExecutionStates[CTTI<T>()];
+            return ECSTasks.emplace([this,range,state,body](tf::Subflow& sf){
+                ForEachWithPolicy(sf, *range, *state, body);
+            }).name(StrFormat("{}",type_name<T>().data()));
+        }
+
+        // the component types a System reads and writes, in registration order
+        struct SystemAccessRecord{
+            ctti_t system;
+            tf::Task task;
+            Vector<ctti_t> reads, writes;
+
+            inline bool ConflictsWith(const SystemAccessRecord& other) const{
+                auto overlaps = [](const Vector<ctti_t>& a, const Vector<ctti_t>& b){
+                    return std::any_of(a.begin(), a.end(), [&b](ctti_t type){
+                        return std::find(b.begin(), b.end(), type) != b.end();
+                    });
+                };
+                return overlaps(writes, other.writes) || overlaps(writes, other.reads) || overlaps(reads, other.writes);
+            }
+        };
+        Vector<SystemAccessRecord> systemAccess;
+
+        template<bool polymorphic, typename T, typename ... A, size_t ... i>
+        inline void RecordSystemAccess(SystemAccessRecord& record, std::index_sequence<i...>){
+            // polymorphic Systems receive every derived type, so treat them as writing all of them
+            ((!polymorphic && SystemAccess<T,A...>::template IsReadOnly<i>() ? record.reads : record.writes).push_back(CTTI<StripChanged_t<A>>()), ...);
+        }
+
+        /**
+         Order a newly added System after every previously added System that writes a type it uses,
+         or uses a type it writes. Systems that only read the same types are left to run in parallel.
+         The new task has no successors yet, so these edges cannot form a cycle.
+         */
+        template<bool polymorphic, typename T, typename ... A>
+        inline void InferSystemDependencies(tf::Task do_task){
+            SystemAccessRecord record{CTTI<T>(), do_task, {}, {}};
+            RecordSystemAccess<polymorphic,T,A...>(record, std::index_sequence_for<A...>());
+            for(const auto& other : systemAccess){
+                if (record.ConflictsWith(other)){
+                    do_task.succeed(other.task);
+                }
+            }
+            systemAccess.push_back(std::move(record));
+        }
+
+        // true if to runs after from, directly or transitively
+        static bool TaskReaches(tf::Task from, tf::Task to){
+            Vector<tf::Task> stack{from}, visited;
+            while(!stack.empty()){
+                auto task = stack.back();
+                stack.pop_back();
+                if (task == to){
+                    return true;
+                }
+                if (std::find(visited.begin(), visited.end(), task) != visited.end()){
+                    continue;
+                }
+                visited.push_back(task);
+                task.for_each_successor([&stack](tf::Task successor){
+                    stack.push_back(successor);
+                });
+            }
+            return false;
+        }
+    public:
+        /**
+         Records structural changes (creating and destroying entities, adding and removing components)
+         so that Systems running in parallel do not modify component storage while other Systems iterate it.
+         Each worker thread records into its own buffer, so recording does not lock. The World applies
+         every buffer in one batch after the ECS tasks finish, before PostTick.
+         */
+        class CommandBuffer{
+            friend class World;
+            // playback order: creations, then component changes grouped by type, then destructions
+            enum class Kind : uint8_t{
+                Create,
+                Component,
+                Destroy
+            };
+            struct Command{
+                Function<void(World*, entity_t)> fn;    // invoked with the target entity's local id
+                entity_t global_id;
+                uint32_t type;                          // ComponentTypeIndex of the component
+                Kind kind;
+            };
+            Vector<Command> commands;
+        public:
+            template<typename T, typename ... A>
+            inline void CreatePrototype(A ... args){
+                commands.push_back(Command{[=](World* world, entity_t){
+                    world->CreatePrototype<T>(args...);
+                }, INVALID_ENTITY, 0, Kind::Create});
+            }
+            
+            /**
+             @param global_id the entity to add the component to (Entity::id)
+             @param args the arguments to construct the component with. These are copied.
+             */
+            template<typename T, typename ... A>
+            inline void EmplaceComponent(entity_t global_id, A ... args){
+                commands.push_back(Command{[=](World* world, entity_t local_id){
+                    world->EmplaceComponent<T>(local_id, args...);
+                }, global_id, ComponentTypeIndex<T>(), Kind::Component});
+            }
+            
+            /**
+             @param global_id the entity to remove the component from (Entity::id)
+             */
+            template<typename T>
+            inline void DestroyComponent(entity_t global_id){
+                commands.push_back(Command{[](World* world, entity_t local_id){
+                    if (world->HasComponent<T>(local_id)){
+                        world->DestroyComponent<T>(local_id);
+                    }
+                }, global_id, ComponentTypeIndex<T>(), Kind::Component});
+            }
+            
+            /**
+             @param global_id the entity to destroy (Entity::id)
+             */
+            inline void Destroy(entity_t global_id){
+                commands.push_back(Command{{}, global_id, 0, Kind::Destroy});
+            }
+        };
+        
+        // a run of entities with consecutive ids, created together
+        struct EntityBatch{
+            entity_t firstGlobal = INVALID_ENTITY;  // Entity(firstGlobal + i) is the i-th entity
+            entity_t firstLocal = INVALID_ENTITY;
+            entity_t count = 0;
+        };
+        
+        /**
+         Create many empty entities at once. Their ids are consecutive, and are never reused ids.
+         @param count the number of entities to create
+         @return the batch that was created
+         */
+        EntityBatch CreateEntities(entity_t count);
+        
+        /**
+         Create many entities with the same components. Each component type's storage is reserved once, then
+         the components are default-constructed a type at a time.
+         @param count the number of entities to create
+         @param initFn invoked for each entity with its global id and a reference to each of its components, to initialize them
+         @return the batch that was created
+         */
+        template<typename ... T, typename func_t>
+        inline EntityBatch SpawnBatch(entity_t count, const func_t& initFn){
+            auto batch = CreateEntities(count);
+            if (count == 0){
+                return batch;
+            }
+            (EmplaceBatch<T>(batch), ...);
+            for(entity_t i = 0; i < count; i++){
+                initFn(batch.firstGlobal + i, GetComponent<T>(batch.firstLocal + i)...);
+            }
+            return batch;
+        }
+        
+        /**
+         Destroy many entities at once. Each component type is removed from the whole batch before moving to the next.
+         @param entities a container of Entity or global entity ids. All must belong to this World.
+         */
+        template<typename container_t>
+        inline void DestroyEntities(const container_t& entities){
+            Vector<entity_t> global_ids;
+            global_ids.reserve(std::distance(std::begin(entities), std::end(entities)));
+            for(const auto& entity : entities){
+                if constexpr (std::is_integral<std::decay_t<decltype(entity)>>::value){
+                    global_ids.push_back(entity);
+                }
+                else{
+                    global_ids.push_back(entity.id);
+                }
+            }
+            DestroyEntities(global_ids.data(), global_ids.size());
+        }
+        
+        /**
+         @return the command buffer for the calling thread
+         @note call this from the main thread or from inside a System, not from other threads
+         */
+        CommandBuffer& GetCommandBuffer();
+        
+        /**
+         Apply the commands recorded in every command buffer: creations first, then component changes grouped by type,
+         then destructions. Commands for entities destroyed or moved to another World since recording are skipped.
+         Tick calls this after the Systems run, so it is only needed to apply commands recorded outside a tick.
+         @note call this from the main thread, while no Systems are running
+         */
+        void PlaybackCommands();
         
         template<typename T, typename ... A>
         inline T CreatePrototype(A ... args){
@@ -669,34 +1287,113 @@ namespace RavEngine {
             return en;
         }
         
+        /**
+         Create the group that a Filter or System over these types iterates, instead of on first use. Filters in parallel
+         tasks can still create groups, but they wait on each other while one is created.
+         @note call this from the main thread, while no Systems are running
+         */
+        template<typename ... A>
+        inline void RegisterQuery(){
+            static_assert(sizeof ... (A) > 1, "Only Filters over more than one type use a group");
+            static_assert(!(IsChunked<A> || ...), "Chunked components do not use groups");
+            GetQueryGroup<A...>();
+        }
+        
         template<typename ... A, typename func>
         inline void Filter(func& f){
-            FilterGeneric<A...>(FuncMode<func, false>{ f });
+            // a cursor shared by every Filter of a type would let one caller consume the changes another is waiting for
+            static_assert(!(IsChanged<A> || ...), "Use FilterChanged with a cursor of your own to Filter Changed<T>");
+            if constexpr ((IsChunked<A> && ...)){
+                auto scale = GetCurrentFPSScale();
+                auto fn = [&](A& ... comps){
+                    f(scale, comps...);
+                };
+                chunkedComponents.ForEach<A...>(fn);
+            }
+            else{
+                static_assert(!(IsChunked<A> || ...), "A Filter cannot mix chunked and SparseSet components");
+                FilterGeneric<A...>(FuncMode<func, false>{ f });
+            }
+        }
+        
+        /**
+         Visit the components of type T that changed since the cursor was last used. Each caller keeps its own cursor,
+         so callers do not take changes from each other.
+         @param f the function to call with (float fpsScale, T&)
+         @param cursor the scan position, which should start at 0
+         */
+        template<typename T, typename func>
+        inline void FilterChanged(func& f, uint64_t& cursor){
+            static_assert(!IsChunked<T>, "Chunked components do not track changes");
+            auto set = MakeIfNotExists<T>();
+            const auto since = set->BeginChangeScan(cursor);
+            const auto scale = GetCurrentFPSScale();
+            for(entity_t i = 0; i < set->DenseSize(); i++){
+                if (set->ChangedSince(i, since)){
+                    f(scale, set->Get(i));
+                }
+            }
         }
         
         template<typename ... A, typename func>
         inline void FilterPolymorphic(func& f){
+            static_assert(!(IsChunked<A> || ...), "Chunked components cannot be queried polymorphically");
             FilterGeneric<A...>(FuncMode<func, true>{ f });
         }
         
-        // this does not check if the entity actually has the component
-        // instead it iterates over keys in the hashtable
+        /**
+         Recalculate the world matrix of every Transform changed since the last update. This runs once per tick
+         after the Systems, so it only needs to be called to read cached matrices before the next tick.
+         */
+        void UpdateTransforms();
+        
+        /**
+         Find the enabled StaticMeshes whose world bounds overlap a box, without going through the physics scene.
+         Bounds are as of the last frame rendered.
+         @param box the world-space box
+         @param f called with the global id of the owner of every overlapping StaticMesh
+         */
+        template<typename F>
+        inline void QueryStaticGeometry(const AABB& box, const F& f) const{
+            staticGeometry.QueryBox(box, [this,&f](uint32_t item){
+                f(staticGeometryItems[item]);
+            });
+        }
+        
+        /**
+         Find the enabled StaticMeshes whose world bounds a ray passes through, in no particular order.
+         Bounds are as of the last frame rendered.
+         @param origin the start of the ray
+         @param direction the direction of the ray
+         @param maxDistance how far along the ray to look, in multiples of direction
+         @param f called with the global id of the owner of every StaticMesh hit, and the distance at which the ray enters its bounds
+         */
+        template<typename F>
+        inline void RaycastStaticGeometry(const vector3& origin, const vector3& direction, decimalType maxDistance, const F& f) const{
+            staticGeometry.QueryRay(origin, direction, maxDistance, [this,&f](uint32_t item, decimalType distance){
+                f(staticGeometryItems[item], distance);
+            });
+        }
+        
+        // visits only the types the entity has, using its component mask
         template<typename func_t>
         inline void EnumerateComponentsOn(entity_t local_id, const func_t& fn){
-            for(auto& componentRow : componentMap){
-                auto& sp_erased = componentRow.second;
-                fn(sp_erased);
-            }
+            ForEachComponentSet(local_id, fn);
         }
         
         // return the new local id
         inline entity_t AddEntityFrom(World* other,entity_t other_local_id){
             auto newID = CreateEntity();
             
+            other->chunkedComponents.MoveEntityTo(other_local_id, chunkedComponents, newID);
+            for(auto& pair : other->queryGroups){
+                pair.second.Remove(other_local_id);
+            }
             other->EnumerateComponentsOn(other_local_id, [&](SparseSetErased& sp_erased){
                 // call the moveFn to move the other entity data into this
-                sp_erased.moveFn(other_local_id,newID,this);
+                sp_erased.vtable->moveFn(&sp_erased,other_local_id,newID,this);
             });
+            other->ClearComponentBits(other_local_id);
             other->localToGlobal[other_local_id] = INVALID_ENTITY;
             return newID;
         }
@@ -712,24 +1409,83 @@ namespace RavEngine {
             
             auto ptr = &ecsRangeSizes[CTTI<T>()];
             
-            FuncModeCopy<T,polymorphic> fm{system};
-            
-            auto fd = GenFilterData<A...>(fm);
-            
-            FilterOneModeCopy fom(fm,fd.ptrs);
-            
-            auto setptr = fd.getMainFilter();
-            
-            // value update
-            auto range_update = ECSTasks.emplace([this,ptr,setptr](){
-                *ptr = static_cast<pos_t>(setptr->DenseSize());
-            }).name(StrFormat("{} range update",type_name<T>()));
-            
-            auto do_task = ECSTasks.for_each_index(pos_t(0),std::ref(*ptr),pos_t(1),[this,fom](auto i) mutable{
-                auto scale = GetCurrentFPSScale();
-                FilterOne<A...>(fom,i,scale);
-            }).name(StrFormat("{}",type_name<T>().data()));
+            tf::Task range_update, do_task;
+            if constexpr ((IsChanged<A> || ...)){
+                static_assert(sizeof ... (A) == 1 && !polymorphic, "Changed<T> must be the only type in a System");
+                using component_t = std::tuple_element_t<0, std::tuple<StripChanged_t<A>...>>;
+                static_assert(!IsChunked<component_t>, "Chunked components do not track changes");
+                // gather the changed components up front, then split them between threads like a dense query
+                auto set = MakeIfNotExists<component_t>();
+                auto changed = &changedSystemRanges[CTTI<T>()];
+                range_update = ECSTasks.emplace([ptr,set,changed](){
+                    changed->indices.clear();
+                    const auto since = set->BeginChangeScan(changed->cursor);
+                    for(entity_t i = 0; i < set->DenseSize(); i++){
+                        if (set->ChangedSince(i, since)){
+                            changed->indices.push_back(i);
+                        }
+                    }
+                    *ptr = static_cast<pos_t>(changed->indices.size());
+                }).name(StrFormat("{} range update",type_name<T>()));
+                
+                do_task = EmplaceSystemTask<T>(ptr,[this,set,changed,system](pos_t i) mutable{
+                    system(GetCurrentFPSScale(), set->Get(changed->indices[i]));
+                });
+            }
+            else if constexpr ((IsChunked<A> && ...)){
+                static_assert(!polymorphic, "Chunked components cannot be queried polymorphically");
+                // one task per chunk, each iterating its rows linearly
+                auto chunks = &chunkedSystemRanges[CTTI<T>()];
+                range_update = ECSTasks.emplace([this,ptr,chunks](){
+                    chunkedComponents.CollectChunks<A...>(*chunks);
+                    *ptr = static_cast<pos_t>(chunks->size());
+                }).name(StrFormat("{} range update",type_name<T>()));
+                
+                do_task = EmplaceSystemTask<T>(ptr,[this,chunks,system](pos_t i) mutable{
+                    auto scale = GetCurrentFPSScale();
+                    auto fn = [&](A& ... comps){
+                        system(scale, comps...);
+                    };
+                    chunkedComponents.ForEachInChunk<A...>((*chunks)[i], fn);
+                });
+            }
+            else{
+                static_assert(!(IsChunked<A> || ...), "A System cannot mix chunked and SparseSet components");
+                FuncModeCopy<T,polymorphic> fm{system};
+                
+                auto fd = GenFilterData<A...>(fm);
+                
+                FilterOneModeCopy fom(fm,fd.ptrs);
+                
+                if constexpr (!polymorphic && sizeof ... (A) > 1){
+                    // iterate only the entities that have every type
+                    auto group = GetQueryGroup<A...>();
+                    range_update = ECSTasks.emplace([ptr,group](){
+                        *ptr = static_cast<pos_t>(group->entities.size());
+                    }).name(StrFormat("{} range update",type_name<T>()));
+                    
+                    do_task = EmplaceSystemTask<T>(ptr,[this,fom,group](pos_t i) mutable{
+                        auto scale = GetCurrentFPSScale();
+                        auto owner = group->entities[i];
+                        fom.fm.f(scale,FilterComponentGet<A>(owner,fom.ptrs[Index_v<A, A...>])...);
+                    });
+                }
+                else{
+                    auto setptr = fd.getMainFilter();
+                    
+                    // value update
+                    range_update = ECSTasks.emplace([this,ptr,setptr](){
+                        *ptr = static_cast<pos_t>(setptr->DenseSize());
+                    }).name(StrFormat("{} range update",type_name<T>()));
+                    
+                    do_task = EmplaceSystemTask<T>(ptr,[this,fom](pos_t i) mutable{
+                        auto scale = GetCurrentFPSScale();
+                        FilterOne<A...>(fom,i,scale);
+                    });
+                }
+            }
             range_update.precede(do_task);
+            InferSystemDependencies<polymorphic,T,A...>(do_task);
             
             auto pair = std::make_pair(range_update,do_task);
             
@@ -738,12 +1494,30 @@ namespace RavEngine {
             return pair;
         }
         
+        /**
+         Change how a System's entities are divided between threads
+         @param policy the policy to use
+         @param chunkSize the number of entities per task, for ExecutionPolicy::StaticChunk
+         */
+        template<typename T>
+        inline void SetSystemExecutionPolicy(ExecutionPolicy policy, pos_t chunkSize = 1){
+            auto& state = systemExecutionStates[CTTI<T>()];
+            state.policy = policy;
+            state.chunkSize = std::max<pos_t>(chunkSize, 1);
+        }
+        
+        /**
+         Make System T run after System U. Systems that access the same component types are ordered automatically
+         from the constness of their operator() parameters, in the order they were added, so this is only needed
+         for ordering that their signatures do not express.
+         */
         template<typename T, typename U>
         inline void CreateDependency(){
             // T depends on (runs after) U
             auto& tPair = typeToSystem.at(CTTI<T>());
             auto& uPair = typeToSystem.at(CTTI<U>());
             
+            assert(!TaskReaches(tPair.second, uPair.second) && "U already runs after T, possibly because of their component access. Add the Systems in the opposite order.");
             tPair.second.succeed(uPair.second);
         }
         
@@ -776,6 +1550,9 @@ namespace RavEngine {
             ECSTasks.erase(tpair.first);
             ECSTasks.erase(tpair.second);
             typeToSystem.erase(CTTI<T>());
+            systemAccess.erase(std::remove_if(systemAccess.begin(), systemAccess.end(), [](const SystemAccessRecord& record){
+                return record.system == CTTI<T>();
+            }), systemAccess.end());
         }
         
         template<typename T, typename ... A, typename interval_t, typename ... Args>
@@ -818,6 +1595,40 @@ namespace RavEngine {
             }
         };   
         
+        // per-thread render data, merged into the current FrameData after extraction so that threads never share a map
+        struct RenderBucket{
+            decltype(FrameData::opaques) opaques;
+            decltype(FrameData::skinnedOpaques) skinnedOpaques;
+        };
+        Vector<RenderBucket> renderBuckets;     // indexed by WorkerSlot
+        SystemExecutionState staticExtraction, skinnedExtraction, instancedExtraction;
+
+        // StaticMeshes grouped by mesh and material, kept between frames. Membership is only revisited when a
+        // StaticMesh is added, removed, or marked changed, so each frame just writes matrices into its slot.
+        using static_batch_key_t = decltype(FrameData::opaques)::key_type;
+        StaticBatches<static_batch_key_t> staticBatches;
+        uint64_t staticBatchCursor = 0;
+        size_t staticBatchGeneration = 0;
+        Vector<InstanceTransform*> staticBatchOutputs;  // where each batch writes its matrices this frame
+        Vector<uint8_t> staticVisible;          // by flattened index
+        Vector<pos_t> staticOutputSlot;         // by flattened index, the position of each visible mesh in its batch's output
+
+        // the world bounds of the StaticMeshes in the batches, rebuilt when membership changes and refit when they move
+        BVH staticGeometry;
+        Vector<entity_t> staticGeometryItems;       // global id of each item's owner
+        PagedSparseArray<pos_t, INVALID_INDEX> staticGeometryItemOf;    // by global id
+        bool staticGeometryStale = true;
+        void UpdateStaticGeometry();
+
+        CullingVolumes culling;
+        std::atomic<uint32_t> culledObjects = 0, submittedObjects = 0;
+        std::atomic<uint32_t> culledLights = 0, submittedLights = 0, culledShadowCasters = 0, submittedShadowCasters = 0;
+        
+        void UpdateStaticBatches();
+
+        // 0 for threads outside the executor, then one per executor worker
+        static size_t WorkerSlot();
+        
         SparseSet<struct StaticMesh>::const_iterator geobegin, geoend;
         SparseSet<struct InstancedStaticMesh>::const_iterator instancedBegin, instancedEnd;
         SparseSet<struct SkinnedMeshComponent>::const_iterator skinnedgeobegin, skinnedgeoend;
@@ -826,13 +1637,25 @@ namespace RavEngine {
              std::chrono::duration<double, std::micro> interval;
              std::chrono::time_point<e_clock_t> last_timestamp = e_clock_t::now();
         };
+        Vector<CommandBuffer> commandBuffers;         // indexed by WorkerSlot
+        Vector<CommandBuffer::Command> commandBatch;
+        Vector<entity_t> commandTargets;              // the local id of each command's entity in commandBatch, if it is still in this World
+        
         UnorderedNodeMap<ctti_t, TimedSystemEntry> timedSystemRecords;
         UnorderedNodeMap<ctti_t, pos_t> ecsRangeSizes;
+        UnorderedNodeMap<ctti_t, Vector<ArchetypeStorage::ChunkRef>> chunkedSystemRanges;
+        struct ChangedSystemRange{
+            uint64_t cursor = 0;
+            Vector<entity_t> indices;   // dense indices of the components that changed since the System last ran
+        };
+        UnorderedNodeMap<ctti_t, ChangedSystemRange> changedSystemRanges;
         UnorderedMap<ctti_t, std::pair<tf::Task,tf::Task>> typeToSystem;
         		
 		void CreateFrameData();
 		
 		void SetupTaskGraph();
+        
+        TransformHierarchy transformHierarchy;
 		
 		std::chrono::time_point<e_clock_t> time_now = e_clock_t::now();
 		float currentFPSScale = 0.01f;
@@ -882,7 +1705,13 @@ namespace RavEngine {
         // returns the "first" of a component type
         template<typename T>
         inline T& GetComponent(){
-            return componentMap.at(RavEngine::CTTI<T>()).template GetSet<T>()->GetFirst();
+            if constexpr (IsChunked<T>){
+                return chunkedComponents.GetFirst<T>();
+            }
+            else{
+                assert(GetSetErased<T>() != nullptr);
+                return GetSetErased<T>()->template GetSet<T>()->GetFirst();
+            }
         }
         
 		std::string_view worldID{ worldIDbuf,id_size };
@@ -968,8 +1797,9 @@ namespace RavEngine {
         
         template<typename T>
         inline auto GetAllComponentsOfType(){
+            static_assert(!IsChunked<T>, "Chunked components do not live in a SparseSet, use Filter instead");
             std::optional<SparseSet<T>*> ret;
-            if (componentMap.find(CTTI<T>()) != componentMap.end()){
+            if (GetSetErased<T>() != nullptr){
                 ret.emplace(GetRange<T>());
             }
             return ret;
@@ -44,7 +44,7 @@ rvs_all_geo[idx] = v_worldpos.x; rvs_all_geo[idx+1] = v_worldpos.y; rvs_all_geo[
  Calculate the posed (or not) matrices and the normal matrix
  @return the following variables are created: mat4 worldmat, mat3 normalmat
  */
-#define vs_genmats() mat4 worldmat = mtxFromRows(i_data0,i_data1,i_data2,i_data3);\
+#define vs_genmats() mat4 worldmat = mtxFromCols(i_data0,i_data1,i_data2,vec4(0,0,0,1));\
 {\
 	int offset = (NumObjects.z > 0) * (gl_InstanceID * NumObjects.y * 4 + gl_VertexID.x * 4 + NumObjects.w * 4);\
 	mat4 blend = mtxFromRows(rvs_pose[offset],rvs_pose[offset+1],rvs_pose[offset+2],rvs_pose[offset+3]);\
@@ -2,7 +2,7 @@
 #include <bgfx_compute.sh>
 
 BUFFER_WR(output, vec4, 0);	// 4x4 matrices
-BUFFER_RO(pose, vec4, 1);	// 4x4 matrices
+BUFFER_RO(pose, vec4, 1);	// the first 3 rows of 4x4 matrices
 BUFFER_RO(weights, vec4, 2);	// index, influence, index2, influence2 (this is done becaue DirectX backend can only index on float4s)
 
 uniform vec4 NumObjects;		// x = num objects, y = num vertices, z = num bones, w = offset into transient buffer
@@ -24,7 +24,7 @@ void main()
 		
 		const int weightsid = vertID * 2;		//2x vec4 elements elements per vertex, is always the same per vertex
 		
-		const int bone_begin = numBones * objID * 4 + NumObjects.w * 4; //offset to the bone for the correct object
+		const int bone_begin = numBones * objID * 3 + NumObjects.w * 3; //offset to the bone for the correct object
 				
 		//will become the pose matrix
 		mat4 totalmtx = mtxFromRows(vec4(0,0,0,0),vec4(0,0,0,0),vec4(0,0,0,0),vec4(0,0,0,0));
@@ -42,10 +42,8 @@ void main()
 				float weight = weightdata[x].y;
 
 				//get the pose and bindpose of the target joint
-				mat4 posed_mtx;
-				for (int j = 0; j < 4; j++) {
-					posed_mtx[j] = pose[bone_begin + joint_idx * 4 + j];
-				}
+				const int joint_begin = bone_begin + joint_idx * 3;
+				mat4 posed_mtx = mtxFromRows(pose[joint_begin], pose[joint_begin + 1], pose[joint_begin + 2], vec4(0,0,0,1));	// the last row of an affine transform
 				totalmtx += weight * posed_mtx;
 			}	
 		}
@@ -92,7 +92,7 @@ void AnimatorComponent::Tick(float timeScale){
 	auto& pose = GetLocalPose();
 	auto& bindpose = skeleton->GetBindposes();
 	for(int i = 0; i < skinningmats.size(); i++){
-		skinningmats[i] = pose[i] * matrix4(bindpose[i]);
+		skinningmats[i] = InstanceTransform(pose[i] * matrix4(bindpose[i]));
 	}
 
 	// update world poses
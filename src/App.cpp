@@ -378,6 +378,12 @@ int App::run(int argc, char** argv) {
 			inputManager->TickAxes();
 		}
 
+		// instance memory for this frame's extraction, which has to be taken on this thread
+		{
+			auto& arena = GetCurrentFramedata()->instanceArena;
+			arena.Reserve(arena.NextReservation());
+		}
+
 		//tick all worlds
 		for(const auto world : loadedWorlds){
 			world->Tick(scale);
@@ -0,0 +1,81 @@
+#include "BVH.hpp"
+#include <algorithm>
+
+using namespace std;
+using namespace RavEngine;
+
+void BVH::Build(const AABB* bounds, size_t count){
+    itemBounds.assign(bounds, bounds + count);
+    items.resize(count);
+    for(uint32_t i = 0; i < count; i++){
+        items[i] = i;
+    }
+    leafOfItem.resize(count);
+    nodes.clear();
+    parents.clear();
+    if (count > 0){
+        nodes.reserve(2 * (count / max_leaf_size + 1));
+        parents.reserve(nodes.capacity());
+        Build(0, static_cast<uint32_t>(count), 0);
+    }
+    dirty.assign(nodes.size(), 0);
+}
+
+uint32_t BVH::Build(uint32_t begin, uint32_t end, uint32_t parent){
+    const auto idx = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+    parents.push_back(parent);
+
+    AABB bounds = itemBounds[items[begin]];
+    AABB centers{bounds.Center(), bounds.Center()};
+    for(auto i = begin + 1; i < end; i++){
+        const auto& item = itemBounds[items[i]];
+        bounds = bounds.Union(item);
+        centers = centers.Union(AABB{item.Center(), item.Center()});
+    }
+    nodes[idx].bounds = bounds;
+
+    if (end - begin <= max_leaf_size){
+        nodes[idx].first = begin;
+        nodes[idx].count = end - begin;
+        for(auto i = begin; i < end; i++){
+            leafOfItem[items[i]] = idx;
+        }
+        return idx;
+    }
+
+    // split at the median along the axis the centers are most spread out on
+    const auto spread = centers.max - centers.min;
+    const int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+    const auto mid = begin + (end - begin) / 2;
+    std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end, [this,axis](uint32_t a, uint32_t b){
+        return itemBounds[a].Center()[axis] < itemBounds[b].Center()[axis];
+    });
+    Build(begin, mid, idx);
+    nodes[idx].first = Build(mid, end, idx);
+    return idx;
+}
+
+void BVH::Refit(){
+    // children come after their parents, so walking backwards finishes every child before its parent
+    for(auto i = nodes.size(); i > 0; i--){
+        const auto idx = static_cast<uint32_t>(i - 1);
+        if (!dirty[idx]){
+            continue;
+        }
+        dirty[idx] = 0;
+        auto& node = nodes[idx];
+        if (node.IsLeaf()){
+            node.bounds = itemBounds[items[node.first]];
+            for(uint32_t k = 1; k < node.count; k++){
+                node.bounds = node.bounds.Union(itemBounds[items[node.first + k]]);
+            }
+        }
+        else{
+            node.bounds = nodes[idx + 1].bounds.Union(nodes[node.first].bounds);
+        }
+        if (idx > 0){
+            dirty[parents[idx]] = 1;
+        }
+    }
+}
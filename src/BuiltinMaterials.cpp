@@ -4,15 +4,14 @@
 
 using namespace RavEngine;
 
-void PBRMaterialInstance::DrawHook(){
-	if (!albedo) {
-		albedo = TextureManager::defaultTexture;
-	}
-	albedo->Bind(0, mat->albedoTxUniform);
+void PBRMaterialInstance::DrawHook(bgfx::Encoder* encoder){
+	// rows sharing this instance can be drawn from different threads, so fall back without assigning
+	const auto& texture = albedo ? albedo : TextureManager::defaultTexture;
+	texture->Bind(encoder, 0, mat->albedoTxUniform);
 		
-	mat->albedoColorUniform.SetValues(&color, 1);
+	mat->albedoColorUniform.SetValues(encoder, &color, 1);
 }
 
-void GUIMaterialInstance::DrawHook(){
-	bgfx::setTexture(0, mat->sampler, mat->texture);
+void GUIMaterialInstance::DrawHook(bgfx::Encoder* encoder){
+	encoder->setTexture(0, mat->sampler, mat->texture);
 }
@@ -0,0 +1,121 @@
+#include "DrawSortKey.hpp"
+#include "DataStructures.hpp"
+#include <taskflow/taskflow.hpp>
+#include <array>
+
+using namespace std;
+using namespace RavEngine;
+
+namespace{
+    constexpr size_t radix_bytes = sizeof(uint64_t), radix_buckets = 256;
+    constexpr size_t min_keys_per_chunk = 4096;     // below this, a pass is not worth handing to other threads
+    using histogram_t = array<array<uint32_t, radix_buckets>, radix_bytes>;
+
+    inline uint32_t Digit(uint64_t key, size_t byte){
+        return static_cast<uint32_t>((key >> (byte * 8)) & 0xFF);
+    }
+}
+
+void RavEngine::RadixSort(uint64_t* keys, uint32_t* values, size_t n, tf::Executor* executor){
+    if (n < 2){
+        return;
+    }
+    size_t numChunks = 1;
+    if (executor != nullptr){
+        numChunks = std::clamp<size_t>(n / min_keys_per_chunk, 1, executor->num_workers());
+    }
+    const size_t chunkSize = (n + numChunks - 1) / numChunks;
+    auto chunkBegin = [&](size_t c){
+        return std::min(n, c * chunkSize);
+    };
+
+    // runs body for every chunk, on the executor's workers if the keys were split
+    auto forEachChunk = [&](const auto& body){
+        if (numChunks == 1){
+            body(size_t(0));
+            return;
+        }
+        tf::Taskflow flow;
+        flow.for_each_index(size_t(0), numChunks, size_t(1), body);
+        executor->run(flow).wait();
+    };
+
+    // the histograms of every byte are found in one read, since reordering keys does not change them
+    Vector<histogram_t> chunkHistograms(numChunks);
+    forEachChunk([&](size_t c){
+        auto& histogram = chunkHistograms[c];
+        for(auto& byte : histogram){
+            byte.fill(0);
+        }
+        for(size_t i = chunkBegin(c); i < chunkBegin(c + 1); i++){
+            for(size_t byte = 0; byte < radix_bytes; byte++){
+                histogram[byte][Digit(keys[i], byte)]++;
+            }
+        }
+    });
+    histogram_t histogram = chunkHistograms[0];
+    for(size_t c = 1; c < numChunks; c++){
+        for(size_t byte = 0; byte < radix_bytes; byte++){
+            for(size_t digit = 0; digit < radix_buckets; digit++){
+                histogram[byte][digit] += chunkHistograms[c][byte][digit];
+            }
+        }
+    }
+
+    Vector<uint64_t> keyScratch(n);
+    Vector<uint32_t> valueScratch(n);
+    uint64_t* keysIn = keys, *keysOut = keyScratch.data();
+    uint32_t* valuesIn = values, *valuesOut = valueScratch.data();
+    Vector<array<uint32_t, radix_buckets>> counts(numChunks), offsets(numChunks);
+    bool moved = false;
+
+    for(size_t byte = 0; byte < radix_bytes; byte++){
+        // every key has the same value here, so this pass would not move anything
+        if (histogram[byte][Digit(keys[0], byte)] == n){
+            continue;
+        }
+
+        // each pass moves keys between chunks, so the chunks' counts are only known up front for the first one
+        if (numChunks == 1){
+            counts[0] = histogram[byte];
+        }
+        else if (!moved){
+            for(size_t c = 0; c < numChunks; c++){
+                counts[c] = chunkHistograms[c][byte];
+            }
+        }
+        else{
+            forEachChunk([&](size_t c){
+                counts[c].fill(0);
+                for(size_t i = chunkBegin(c); i < chunkBegin(c + 1); i++){
+                    counts[c][Digit(keysIn[i], byte)]++;
+                }
+            });
+        }
+
+        // each chunk writes its keys of a digit after the earlier chunks' keys of that digit, which keeps the sort stable
+        uint32_t offset = 0;
+        for(size_t digit = 0; digit < radix_buckets; digit++){
+            for(size_t c = 0; c < numChunks; c++){
+                offsets[c][digit] = offset;
+                offset += counts[c][digit];
+            }
+        }
+        forEachChunk([&](size_t c){
+            auto& chunkOffsets = offsets[c];
+            for(size_t i = chunkBegin(c); i < chunkBegin(c + 1); i++){
+                const auto dest = chunkOffsets[Digit(keysIn[i], byte)]++;
+                keysOut[dest] = keysIn[i];
+                valuesOut[dest] = valuesIn[i];
+            }
+        });
+        std::swap(keysIn, keysOut);
+        std::swap(valuesIn, valuesOut);
+        moved = true;
+    }
+
+    if (keysIn != keys){
+        std::copy(keysIn, keysIn + n, keys);
+        std::copy(valuesIn, valuesIn + n, values);
+    }
+}
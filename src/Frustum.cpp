@@ -0,0 +1,75 @@
+#include "Frustum.hpp"
+#include <ozz/base/maths/simd_math.h>
+
+using namespace std;
+using namespace RavEngine;
+
+Frustum::Frustum(const matrix4& m){
+    // rows of the matrix, which glm stores by column
+    auto row = [&m](int r){
+        return std::array<float, 4>{static_cast<float>(m[0][r]), static_cast<float>(m[1][r]), static_cast<float>(m[2][r]), static_cast<float>(m[3][r])};
+    };
+    const auto r3 = row(3);
+    for(int axis = 0; axis < 3; axis++){
+        const auto r = row(axis);
+        for(int c = 0; c < 4; c++){
+            planes[axis * 2][c] = r3[c] + r[c];
+            planes[axis * 2 + 1][c] = r3[c] - r[c];
+        }
+    }
+}
+
+void Frustum::TransformBounds(const matrix4& transform, const MeshAsset::Bounds& local, vector3& center, vector3& extent){
+    const vector3 localCenter((local.min[0] + local.max[0]) / 2, (local.min[1] + local.max[1]) / 2, (local.min[2] + local.max[2]) / 2);
+    const vector3 localExtent((local.max[0] - local.min[0]) / 2, (local.max[1] - local.min[1]) / 2, (local.max[2] - local.min[2]) / 2);
+    center = vector3(transform * vector4(localCenter, 1));
+    for(int r = 0; r < 3; r++){
+        extent[r] = std::abs(transform[0][r]) * localExtent.x + std::abs(transform[1][r]) * localExtent.y + std::abs(transform[2][r]) * localExtent.z;
+    }
+}
+
+uint32_t Frustum::TestBoxes(const vector3* centers, const vector3* extents, size_t n) const{
+    assert(n <= simd_width);
+    using namespace ozz::math;
+    // one box per lane, with the unused lanes repeating the first box
+    float c[3][simd_width], e[3][simd_width];
+    for(size_t lane = 0; lane < simd_width; lane++){
+        const auto i = lane < n ? lane : 0;
+        for(int axis = 0; axis < 3; axis++){
+            c[axis][lane] = static_cast<float>(centers[i][axis]);
+            e[axis][lane] = static_cast<float>(extents[i][axis]);
+        }
+    }
+    const SimdFloat4 cx = simd_float4::LoadPtrU(c[0]), cy = simd_float4::LoadPtrU(c[1]), cz = simd_float4::LoadPtrU(c[2]);
+    const SimdFloat4 ex = simd_float4::LoadPtrU(e[0]), ey = simd_float4::LoadPtrU(e[1]), ez = simd_float4::LoadPtrU(e[2]);
+    const SimdFloat4 zero = simd_float4::zero();
+
+    // a box is outside if it is entirely behind any plane
+    SimdInt4 outside = simd_int4::zero();
+    for(const auto& plane : planes){
+        const SimdFloat4 nx = simd_float4::Load1(plane[0]), ny = simd_float4::Load1(plane[1]), nz = simd_float4::Load1(plane[2]);
+        const SimdFloat4 distance = MAdd(cx, nx, MAdd(cy, ny, MAdd(cz, nz, simd_float4::Load1(plane[3]))));
+        const SimdFloat4 radius = MAdd(ex, Abs(nx), MAdd(ey, Abs(ny), ez * Abs(nz)));
+        outside = Or(outside, CmpLt(distance + radius, zero));
+    }
+    const uint32_t lanes = (1u << n) - 1;
+    return ~static_cast<uint32_t>(MoveMask(outside)) & lanes;
+}
+
+size_t Frustum::CullTransforms(const matrix4* transforms, size_t n, const MeshAsset::Bounds& local, matrix4* out) const{
+    size_t written = 0;
+    vector3 centers[simd_width], extents[simd_width];
+    for(size_t begin = 0; begin < n; begin += simd_width){
+        const auto count = std::min(simd_width, n - begin);
+        for(size_t k = 0; k < count; k++){
+            TransformBounds(transforms[begin + k], local, centers[k], extents[k]);
+        }
+        const auto visible = TestBoxes(centers, extents, count);
+        for(size_t k = 0; k < count; k++){
+            if (visible & (1u << k)){
+                out[written++] = transforms[begin + k];
+            }
+        }
+    }
+    return written;
+}
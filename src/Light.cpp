@@ -52,6 +52,10 @@ void DirectionalLight::DebugDraw(RavEngine::DebugDrawer& dbg, const Transform& t
 	dbg.DrawCapsule(tr.CalculateWorldMatrix(), debug_color, 1, 2);
 }
 
+vector3 DirectionalLight::Direction(const Transform& transform){
+	return transform.WorldUp();
+}
+
 void DirectionalLight::AddInstanceData(float* offset) const{
 	offset[0] = color.R;
 	offset[1] = color.G;
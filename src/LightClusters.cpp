@@ -0,0 +1,127 @@
+#include "LightClusters.hpp"
+#include "Types.hpp"
+#include <cmath>
+
+using namespace std;
+using namespace RavEngine;
+
+void LightClusters::SetView(const matrix4& newProjection, float newNear, float newFar){
+    if (newProjection == projection && newNear == nearClip && newFar == farClip && !clusterBounds.empty()){
+        return;
+    }
+    projection = newProjection;
+    nearClip = newNear;
+    farClip = newFar;
+    assert(nearClip > 0 && farClip > nearClip);
+
+    for(uint32_t z = 0; z <= gridZ; z++){
+        sliceDepths[z] = nearClip * std::pow(farClip / nearClip, static_cast<float>(z) / gridZ);
+    }
+
+    // each corner of a tile is a line through view space, which is found from two points on it
+    const auto inverse = glm::inverse(projection);
+    auto unproject = [&inverse](float x, float y, float z){
+        const auto p = inverse * vector4(x, y, z, 1);
+        return vector3(p) / p.w;
+    };
+    auto atDepth = [](const vector3& a, const vector3& b, float depth){
+        const auto t = (-depth - a.z) / (b.z - a.z);
+        return a + (b - a) * decimalType(t);
+    };
+
+    clusterBounds.resize(numClusters);
+    for(uint32_t y = 0; y < gridY; y++){
+        for(uint32_t x = 0; x < gridX; x++){
+            vector3 nearPoints[4], farPoints[4];
+            for(int c = 0; c < 4; c++){
+                const float nx = -1 + 2 * static_cast<float>(x + (c & 1)) / gridX;
+                const float ny = -1 + 2 * static_cast<float>(y + (c >> 1)) / gridY;
+                nearPoints[c] = unproject(nx, ny, -1);
+                farPoints[c] = unproject(nx, ny, 1);
+            }
+            for(uint32_t z = 0; z < gridZ; z++){
+                AABB bounds{vector3(std::numeric_limits<decimalType>::max()), vector3(std::numeric_limits<decimalType>::lowest())};
+                for(int c = 0; c < 4; c++){
+                    for(auto depth : {sliceDepths[z], sliceDepths[z + 1]}){
+                        const auto p = atDepth(nearPoints[c], farPoints[c], depth);
+                        bounds = bounds.Union(AABB{p, p});
+                    }
+                }
+                clusterBounds[Index(x, y, z)] = bounds;
+            }
+        }
+    }
+}
+
+void LightClusters::BeginAssign(const vector4* spheres, size_t count){
+    lights.assign(spheres, spheres + count);
+    counts.assign(numClusters, 0);
+    slots.resize(numClusters * maxLightsPerCluster);
+}
+
+void LightClusters::AssignSlice(uint32_t z){
+    assert(!clusterBounds.empty());     // call SetView first
+    // only the lights that reach this slice's depth range need testing against its tiles
+    const auto sliceNear = -sliceDepths[z], sliceFar = -sliceDepths[z + 1];
+    Vector<uint32_t> candidates;
+    for(uint32_t i = 0; i < lights.size(); i++){
+        const auto& l = lights[i];
+        if (l.z - l.w <= sliceNear && l.z + l.w >= sliceFar){
+            candidates.push_back(i);
+        }
+    }
+    for(uint32_t y = 0; y < gridY; y++){
+        for(uint32_t x = 0; x < gridX; x++){
+            const auto cluster = Index(x, y, z);
+            const auto& bounds = clusterBounds[cluster];
+            auto out = slots.data() + cluster * maxLightsPerCluster;
+            uint32_t count = 0;
+            for(auto i : candidates){
+                const auto& l = lights[i];
+                const vector3 center(l);
+                const auto closest = glm::clamp(center, bounds.min, bounds.max);
+                const auto offset = center - closest;
+                if (glm::dot(offset, offset) <= l.w * l.w && count < maxLightsPerCluster){
+                    out[count++] = i;
+                }
+            }
+            counts[cluster] = count;
+        }
+    }
+}
+
+const Vector<uint32_t>& LightClusters::Pack(){
+    packed.resize(numClusters * 2);
+    for(uint32_t cluster = 0; cluster < numClusters; cluster++){
+        packed[cluster * 2] = static_cast<uint32_t>(packed.size());
+        packed[cluster * 2 + 1] = counts[cluster];
+        const auto first = GetLights(cluster);
+        packed.insert(packed.end(), first, first + counts[cluster]);
+    }
+    return packed;
+}
+
+uint32_t LightClusters::ClusterOf(const vector3& p) const{
+    const auto depth = -p.z;
+    if (depth < nearClip || depth >= farClip){
+        return INVALID_INDEX;
+    }
+    const auto clip = projection * vector4(p, 1);
+    const auto ndc = vector3(clip) / clip.w;
+    const auto x = static_cast<int>(std::floor((ndc.x + 1) / 2 * gridX));
+    const auto y = static_cast<int>(std::floor((ndc.y + 1) / 2 * gridY));
+    if (x < 0 || x >= static_cast<int>(gridX) || y < 0 || y >= static_cast<int>(gridY)){
+        return INVALID_INDEX;
+    }
+    // slices are spaced exponentially, so the one a depth is in is logarithmic
+    auto z = static_cast<uint32_t>(std::log(depth / nearClip) / std::log(farClip / nearClip) * gridZ);
+    z = std::min(z, gridZ - 1);
+    // rounding can put a depth on the edge of a slice into its neighbour
+    if (z > 0 && depth < sliceDepths[z]){
+        z--;
+    }
+    else if (z + 1 < gridZ && depth >= sliceDepths[z + 1]){
+        z++;
+    }
+    return Index(x, y, z);
+}
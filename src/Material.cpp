@@ -21,13 +21,13 @@ bgfx::ShaderHandle loadShader(const  RavEngine::Vector<uint8_t>& data){
 	return bgfx::createShader(mem);
 }
 
-void Material::Draw(const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, int view)
+void Material::Draw(bgfx::Encoder* encoder, const bgfx::VertexBufferHandle& vertexBuffer, const bgfx::IndexBufferHandle& indexBuffer, int view)
 {	
 	//set vertex and index buffer
-	bgfx::setVertexBuffer(0, vertexBuffer);
-	bgfx::setIndexBuffer(indexBuffer);
+	encoder->setVertexBuffer(0, vertexBuffer);
+	encoder->setIndexBuffer(indexBuffer);
 
-	bgfx::submit(view, program);
+	encoder->submit(view, program);
 }
 
 // return the folder name the shaders are stored in
@@ -36,6 +36,7 @@
 #include <fmt/core.h>
 #include <iostream>
 #include "Debug.hpp"
+#include "DrawSortKey.hpp"
 #include <chrono>
 #include <cstdio>
 
@@ -443,12 +444,13 @@ void RenderEngine::Init(const AppConfig& config)
 		.add(bgfx::Attrib::Position, 4, bgfx::AttribType::Float)
 		.end();
 	
+	// one InstanceTransform per joint
 	skinningInputLayout.begin()
 		.add(bgfx::Attrib::Position, 4, bgfx::AttribType::Float)
 		.add(bgfx::Attrib::Position, 4, bgfx::AttribType::Float)
 		.add(bgfx::Attrib::Position, 4, bgfx::AttribType::Float)
-		.add(bgfx::Attrib::Position, 4, bgfx::AttribType::Float)
 		.end();
+	assert(skinningInputLayout.getStride() == sizeof(InstanceTransform));
 	
 	float identity[16] = {
 		1,0,0,0,
@@ -560,7 +562,9 @@ void RenderEngine::Init(const AppConfig& config)
 	timeUniform.emplace("u_time");
 	
 	bgfx::setViewName(Views::FinalBlit, "Final Blit");
-	bgfx::setViewName(Views::DeferredGeo, "Deferred Geometry");
+	for(bgfx::ViewId view = Views::DeferredGeo; view <= Views::DeferredGeoLast; view++){
+		bgfx::setViewName(view, "Deferred Geometry");
+	}
 	bgfx::setViewName(Views::LightingNoShadows, "Lighting Volumes No Shadows");
 
 	bgfx::setViewClear(Views::FinalBlit, BGFX_CLEAR_COLOR);
@@ -682,10 +686,18 @@ void RenderEngine::Draw(Ref<World> worldOwning){
 	RenderEngine::dbgmtx.unlock();
 #endif
 
-	bgfx::ViewId allViews[] = {Views::FinalBlit, Views::DeferredGeo, Views::LightingNoShadows};
-	
+	// the geometry views come first, and are followed directly by the lighting view
+	std::array<bgfx::ViewId, Views::numGeometryViews + 2> allViews;
+	for(bgfx::ViewId view = Views::DeferredGeo; view <= Views::LightingNoShadows; view++){
+		allViews[view - Views::DeferredGeo] = view;
+	}
+	allViews.back() = Views::FinalBlit;
 	
-	bgfx::setViewFrameBuffer(Views::DeferredGeo, gBuffer);
+	// geometry draws run in the order they are recorded, which is the order sortRows chose, rather than bgfx's own order
+	for(bgfx::ViewId view = Views::DeferredGeo; view <= Views::DeferredGeoLast; view++){
+		bgfx::setViewFrameBuffer(view, gBuffer);
+		bgfx::setViewMode(view, bgfx::ViewMode::Sequential);
+	}
 	bgfx::setViewFrameBuffer(Views::LightingNoShadows, lightingBuffer);
     bgfx::setViewMode(Views::LightingNoShadows,bgfx::ViewMode::Sequential);
 
@@ -723,149 +735,235 @@ void RenderEngine::Draw(Ref<World> worldOwning){
 		bgfx::setViewTransform(view, viewmat, projmat);
 	}
 	
+	// rows are submitted in sort key order instead of hash order, so that rows sharing a program, material, or mesh go back to back
+	UnorderedMap<const MaterialInstanceBase*, uint16_t> materialIds;
+	auto sortRows = [&](const auto& rows){
+		using row_t = typename std::decay_t<decltype(rows)>::value_type;
+		Vector<const row_t*> unsorted, sorted;
+		Vector<uint64_t> keys;
+		Vector<uint32_t> order;
+		for(const auto& row : rows){
+			if (row.second.size() == 0){
+				continue;
+			}
+			const auto material = std::get<1>(row.first).get();
+			const auto program = material ? material->GetProgram().idx : numeric_limits<uint16_t>::max();
+			const auto materialId = materialIds.emplace(material, static_cast<uint16_t>(materialIds.size())).first->second;
+			// rows are sorted by their first instance, which is as good a guess at their depth as any
+			const auto& first = row.second.arenaCount > 0 ? *fd->instanceArena.Get(row.second.arenaFirst) : row.second.items.front();
+			const auto distance = glm::distance(vector3(first.rows[3], first.rows[7], first.rows[11]), fd->cameraWorldpos);
+			keys.push_back(DrawSortKey::Make(Views::DeferredGeo, program, materialId, std::get<0>(row.first)->getVertexBuffer().idx, DrawSortKey::DepthBucket(distance)));
+			order.push_back(static_cast<uint32_t>(unsorted.size()));
+			unsorted.push_back(&row);
+		}
+		RadixSort(keys.data(), order.data(), keys.size(), &GetApp()->executor);
+		sorted.reserve(order.size());
+		for(const auto i : order){
+			sorted.push_back(unsorted[i]);
+		}
+		return sorted;
+	};
+	drawStats = {};
+	
     uint32_t allVerticesOffset = 0;
 	uint32_t allIndicesOffset = 0;
 	uint32_t allIndicesIncrement = 0;
-	auto execdraw = [&](const auto& row, const auto& skinningfunc, const auto& bindfunc) {
-		//call Draw with the staticmesh
-		if (std::get<1>(row.first)) {
-            if (row.second.items.size() == 0){
-                return;
-            }
-			skinningfunc(row);
-
-			//fill the buffer using the material to write the material data for each instance
-				//get the stride for the material (only needs the matrix, all others are uniforms?
-			constexpr auto stride = closest_multiple_of(16 * sizeof(float), 16);
-			bgfx::InstanceDataBuffer idb;
-			assert(row.second.items.size() < numeric_limits<uint32_t>::max());	// too many items!
-			Debug::Assert(bgfx::getAvailInstanceDataBuffer(static_cast<uint32_t>(row.second.items.size()), stride) == row.second.items.size(), "Instance data buffer does not have enough space!");
-			bgfx::allocInstanceDataBuffer(&idb, static_cast<uint32_t>(row.second.items.size()), stride);
-			size_t offset = 0;
-			for (const auto& mesh : row.second.items) {
-				//write the data into the idb
-				auto matrix = glm::value_ptr(mesh);
-				float* ptr = (float*)(idb.data + offset);
-
-				copyMat4(matrix, ptr);
-
-				offset += stride;
-			}
-			bgfx::setInstanceDataBuffer(&idb);
-			//set BGFX state
-			bgfx::setState((BGFX_STATE_DEFAULT & ~BGFX_STATE_CULL_MASK) | (std::get<1>(row.first)->doubleSided ? BGFX_STATE_NONE : BGFX_STATE_CULL_CW));
-
-			bindfunc();
-			
-            // both skinend and static need to write to this buffer
-            bgfx::setBuffer(12, allVerticesHandle, bgfx::Access::Write);
-            
-			//bind gbuffer textures
-			for (int i = 0; i < BX_COUNTOF(attachments); i++) {
-				bgfx::setTexture(i, gBufferSamplers[i], attachments[i]);
-			}
-            
-            // update time and other data
-            auto numIndiciesInThisDispatch = std::get<0>(row.first)->GetNumVerts();
-            float timeVals[] = {static_cast<float>(fd->Time),static_cast<float>(allVerticesOffset),static_cast<float>(numIndiciesInThisDispatch),0};
-            allVerticesOffset += numIndiciesInThisDispatch * row.second.items.size();   // need to account for the number of indices
-            timeUniform.value().SetValues(&timeVals, 1);
-
-			std::get<1>(row.first)->Draw(std::get<0>(row.first)->getVertexBuffer(), std::get<0>(row.first)->getIndexBuffer(), matrix4(), Views::DeferredGeo);
-
-			// dispatch the indices copy compute shader
-			bgfx::discard();
-			bgfx::setBuffer(0, std::get<0>(row.first)->getIndexBuffer(), bgfx::Access::Read);
-			bgfx::setBuffer(1, allIndicesHandle, bgfx::Access::Write);
-			timeVals[0] = allIndicesOffset;
-			timeVals[1] = std::get<0>(row.first)->GetNumIndices();
-			timeVals[2] = allIndicesIncrement;
-			timeVals[3] = std::get<0>(row.first)->GetNumVerts();
-			numRowsUniform.SetValues(timeVals, 1);
-			bgfx::dispatch(Views::DeferredGeo, copyIndicesShaderHandle, Debug::AssertSize<uint32_t>(ceil(std::get<0>(row.first)->GetNumIndices() / 64.0)), Debug::AssertSize<uint32_t>(row.second.items.size()), 1);
-			allIndicesOffset += std::get<0>(row.first)->GetNumIndices() * row.second.items.size();	// account for the number of instances
-			allIndicesIncrement += std::get<0>(row.first)->GetNumVerts() * row.second.items.size();	// begin counting from here
-
-		}
-		else {
+	
+	// where a row's instances live, and where its vertices and indices go in the unified scene mesh. These are
+	// found on this thread in submission order, after which the row can be recorded from any thread.
+	struct RowPlacement{
+		bgfx::InstanceDataBuffer idb;
+		uint32_t instanceStart = 0, count = 0;
+		uint32_t verticesOffset = 0, indicesOffset = 0, indicesIncrement = 0;
+	};
+	auto placeRow = [&](const auto& row){
+		if (!std::get<1>(row.first)) {
 			Debug::Fatal("Cannot draw a mesh with no material assigned.");
 		}
+		RowPlacement placement;
+		const auto count = row.second.size();
+		assert(count < numeric_limits<uint32_t>::max());	// too many items!
+		placement.count = static_cast<uint32_t>(count);
+		
+		// the items are already in the instance buffer's layout
+		constexpr auto stride = sizeof(InstanceTransform);
+		if (row.second.items.empty()){
+			// extraction wrote every instance straight into the arena
+			placement.idb = fd->instanceArena.idb;
+			placement.instanceStart = row.second.arenaFirst;
+		}
+		else{
+			Debug::Assert(bgfx::getAvailInstanceDataBuffer(static_cast<uint32_t>(count), stride) == count, "Instance data buffer does not have enough space!");
+			bgfx::allocInstanceDataBuffer(&placement.idb, static_cast<uint32_t>(count), stride);
+			auto out = reinterpret_cast<InstanceTransform*>(placement.idb.data);
+			if (row.second.arenaCount > 0){
+				std::memcpy(out, fd->instanceArena.Get(row.second.arenaFirst), row.second.arenaCount * stride);
+			}
+			std::memcpy(out + row.second.arenaCount, row.second.items.data(), row.second.items.size() * stride);
+		}
+		
+		const auto& mesh = std::get<0>(row.first);
+		placement.verticesOffset = allVerticesOffset;
+		placement.indicesOffset = allIndicesOffset;
+		placement.indicesIncrement = allIndicesIncrement;
+		allVerticesOffset += mesh->GetNumVerts() * placement.count;		// need to account for the number of indices
+		allIndicesOffset += mesh->GetNumIndices() * placement.count;	// account for the number of instances
+		allIndicesIncrement += mesh->GetNumVerts() * placement.count;	// begin counting from here
+		return placement;
 	};
+	
+	// draws recorded to one encoder and its view, and how often consecutive ones changed state
+	struct StateTracker{
+		bgfx::ViewId view = Views::DeferredGeo;
+		DrawStats stats;
+		bgfx::ProgramHandle lastProgram = BGFX_INVALID_HANDLE;
+		bgfx::VertexBufferHandle lastMesh = BGFX_INVALID_HANDLE;
+		const MaterialInstanceBase* lastMaterial = nullptr;
+	};
+	auto execdraw = [&](bgfx::Encoder* encoder, const auto& row, const RowPlacement& placement, const auto& bindfunc, StateTracker& tracker) {
+		const auto& material = std::get<1>(row.first);
+		const auto& mesh = std::get<0>(row.first);
+		encoder->setInstanceDataBuffer(&placement.idb, placement.instanceStart, placement.count);
+		//set BGFX state
+		encoder->setState((BGFX_STATE_DEFAULT & ~BGFX_STATE_CULL_MASK) | (material->doubleSided ? BGFX_STATE_NONE : BGFX_STATE_CULL_CW));
+
+		bindfunc(encoder);
 		
-	for(const auto& row : fd->opaques){
-		execdraw(row, [this](const auto& row) {
-			// do nothing
-		}, [this]() {
-			float values[4] = { 0,0,0,0 };	// pretend there is only one object being 'skinned', the shader will wrap around to only read this matrix
-			numRowsUniform.SetValues(&values, 1);
-			bgfx::setBuffer(11, opaquemtxhandle, bgfx::Access::Read);
-		});
+        // both skinend and static need to write to this buffer
+        encoder->setBuffer(12, allVerticesHandle, bgfx::Access::Write);
+        
+		//bind gbuffer textures
+		for (int i = 0; i < BX_COUNTOF(attachments); i++) {
+			encoder->setTexture(i, gBufferSamplers[i], attachments[i]);
+		}
+        
+        // update time and other data
+        float timeVals[] = {static_cast<float>(fd->Time),static_cast<float>(placement.verticesOffset),static_cast<float>(mesh->GetNumVerts()),0};
+        timeUniform.value().SetValues(encoder, &timeVals, 1);
+
+		const auto program = material->GetProgram();
+		tracker.stats.draws++;
+		tracker.stats.programChanges += program.idx != tracker.lastProgram.idx;
+		tracker.stats.materialChanges += material.get() != tracker.lastMaterial;
+		tracker.stats.meshChanges += mesh->getVertexBuffer().idx != tracker.lastMesh.idx;
+		tracker.lastProgram = program;
+		tracker.lastMesh = mesh->getVertexBuffer();
+		tracker.lastMaterial = material.get();
+
+		material->Draw(encoder, mesh->getVertexBuffer(), mesh->getIndexBuffer(), matrix4(), tracker.view);
+
+		// dispatch the indices copy compute shader
+		encoder->discard();
+		encoder->setBuffer(0, mesh->getIndexBuffer(), bgfx::Access::Read);
+		encoder->setBuffer(1, allIndicesHandle, bgfx::Access::Write);
+		timeVals[0] = placement.indicesOffset;
+		timeVals[1] = mesh->GetNumIndices();
+		timeVals[2] = placement.indicesIncrement;
+		timeVals[3] = mesh->GetNumVerts();
+		numRowsUniform.SetValues(encoder, timeVals, 1);
+		encoder->dispatch(tracker.view, copyIndicesShaderHandle, Debug::AssertSize<uint32_t>(ceil(mesh->GetNumIndices() / 64.0)), placement.count, 1);
+	};
+	
+	// static rows are split across the executor's workers, each recording a contiguous range of them to its own encoder
+	// and view, so that the views run one after another in sorted order. Encoder 0 belongs to this thread, which records
+	// the skinned rows meanwhile, since they share the skinning buffers. They go in the view after the static rows.
+	const auto opaqueRows = sortRows(fd->opaques);
+	Vector<RowPlacement> opaquePlacements;
+	opaquePlacements.reserve(opaqueRows.size());
+	for(const auto row : opaqueRows){
+		opaquePlacements.push_back(placeRow(*row));
+	}
+	auto& executor = GetApp()->executor;
+	constexpr size_t min_rows_per_encoder = 64;
+	const size_t maxEncoderTasks = std::min<size_t>({executor.num_workers(), bgfx::getCaps()->limits.maxEncoders - 1u, Views::numGeometryViews - 1u});
+	const size_t numEncoderTasks = std::clamp<size_t>(opaqueRows.size() / min_rows_per_encoder, 1, std::max<size_t>(maxEncoderTasks, 1));
+	const bool threadedGeometry = numEncoderTasks > 1;
+	Vector<StateTracker> trackers(numEncoderTasks + 1);		// the last one is for this thread's skinned rows
+	for(size_t i = 0; i < trackers.size(); i++){
+		trackers[i].view = static_cast<bgfx::ViewId>(Views::DeferredGeo + i);
+	}
+	auto recordOpaques = [&](size_t task){
+		auto encoder = bgfx::begin(threadedGeometry);
+		assert(encoder != nullptr);		// there are never more tasks than encoders
+		const auto perTask = (opaqueRows.size() + numEncoderTasks - 1) / numEncoderTasks;
+		const auto end = std::min(opaqueRows.size(), (task + 1) * perTask);
+		for(size_t i = task * perTask; i < end; i++){
+			execdraw(encoder, *opaqueRows[i], opaquePlacements[i], [this](bgfx::Encoder* encoder) {
+				float values[4] = { 0,0,0,0 };	// pretend there is only one object being 'skinned', the shader will wrap around to only read this matrix
+				numRowsUniform.SetValues(encoder, &values, 1);
+				encoder->setBuffer(11, opaquemtxhandle, bgfx::Access::Read);
+			}, trackers[task]);
+		}
+		bgfx::end(encoder);
+	};
+	tf::Taskflow geometryFlow;
+	std::optional<tf::Future<void>> opaquesRecorded;
+	if (threadedGeometry){
+		geometryFlow.for_each_index(size_t(0), numEncoderTasks, size_t(1), recordOpaques);
+		opaquesRecorded = executor.run(geometryFlow);
+	}
+	else{
+		recordOpaques(0);
 	}
 	
-	for (const auto& row : fd->skinnedOpaques) {
+	for (const auto rowPtr : sortRows(fd->skinnedOpaques)) {
+		const auto& row = *rowPtr;
 		size_t computeOffsetIndex;
 		float values[4];
-		execdraw(row, [&computeOffsetIndex, &values, this](const auto& row) {
-			// seed compute shader for skinning
-			// input buffer A: skeleton bind pose
-			Ref<SkeletonAsset> skeleton = std::get<2>(row.first);
-			// input buffer B: vertex weights by bone ID
-			auto mesh = std::get<0>(row.first);
-			// input buffer C: unposed vertices in mesh
+		const auto placement = placeRow(row);
+		
+		// seed compute shader for skinning
+		// input buffer A: skeleton bind pose
+		Ref<SkeletonAsset> skeleton = std::get<2>(row.first);
+		// input buffer B: vertex weights by bone ID
+		auto mesh = std::get<0>(row.first);
+		// input buffer C: unposed vertices in mesh
+		
+		// output buffer A: posed output transformations for vertices
+		auto numverts = mesh->GetNumVerts();
+		auto numobjects = row.second.items.size();
+		
+		auto emptySpace = numverts * numobjects;
+		assert(emptySpace < numeric_limits<uint32_t>::max());
+
+		computeOffsetIndex = skinningComputeBuffer.AddEmptySpace(static_cast<uint32_t>(emptySpace), skinningOutputLayout);
+		bgfx::setBuffer(0, skinningComputeBuffer.GetHandle(), bgfx::Access::Write);
+		bgfx::setBuffer(2, mesh->GetWeightsHandle(), bgfx::Access::Read);
+	
+		//pose values, which extraction already packed in the buffer's layout
+		if(row.second.skinningdata.size() > 0){
+			const auto totalsize = row.second.skinningdata.size();
+			assert(totalsize < numeric_limits<uint32_t>::max());	// pose buffer is too big!
+			auto poseStart = poseStorageBuffer.AddData(reinterpret_cast<const uint8_t*>(row.second.skinningdata.data()),static_cast<uint32_t>(totalsize), skinningInputLayout);
 			
-			// output buffer A: posed output transformations for vertices
-			auto numverts = mesh->GetNumVerts();
-			auto numobjects = row.second.items.size();
+			// set skinning uniform
+			values[0] = static_cast<float>(numobjects);
+			values[1] = static_cast<float>(numverts);
+			values[2] = static_cast<float>(skeleton->GetBindposes().size());
+			values[3] = static_cast<float>(poseStart);
+			numRowsUniform.SetValues(&values, 1);
 			
-			auto emptySpace = numverts * numobjects;
-			assert(emptySpace < numeric_limits<uint32_t>::max());
-
-			computeOffsetIndex = skinningComputeBuffer.AddEmptySpace(static_cast<uint32_t>(emptySpace), skinningOutputLayout);
-			bgfx::setBuffer(0, skinningComputeBuffer.GetHandle(), bgfx::Access::Write);
-			bgfx::setBuffer(2, mesh->GetWeightsHandle(), bgfx::Access::Read);
-		
-			//pose SOA values
-			if(row.second.skinningdata.size() > 0){
-				//convert to float from double
-				size_t totalsize = 0;
-				for(const auto& array : row.second.skinningdata){
-					totalsize += array.size();
-				}
-				typedef Array<float,16> arrtype;
-				stackarray(pose_float, arrtype, totalsize);
-				size_t index = 0;
-				for(const auto& array : row.second.skinningdata){
-					//in case of double mode, need to convert to float
-					for(int i = 0; i < array.size(); i++){
-						//populate stack array values
-						auto ptr = glm::value_ptr(array[i]);
-						for(int offset = 0; offset < 16; offset++){
-							pose_float[index][offset] = static_cast<float>(ptr[offset]);
-						}
-						index++;
-					}
-				}
-				assert(totalsize < numeric_limits<uint32_t>::max());	// pose buffer is too big!
-				auto poseStart = poseStorageBuffer.AddData(reinterpret_cast<uint8_t*>(pose_float),static_cast<uint32_t>(totalsize), skinningInputLayout);
-				
-				// set skinning uniform
-				values[0] = static_cast<float>(numobjects);
-				values[1] = static_cast<float>(numverts);
-				values[2] = static_cast<float>(skeleton->GetBindposes().size());
-				values[3] = static_cast<float>(poseStart);
-				numRowsUniform.SetValues(&values, 1);
-				
-				float offsets[4] = {static_cast<float>(computeOffsetIndex),0,0,0};
-				computeOffsetsUniform.SetValues(&offsets, 1);
-				
-				bgfx::setBuffer(1, poseStorageBuffer.GetHandle(), bgfx::Access::Read);
-				bgfx::dispatch(Views::DeferredGeo, skinningShaderHandle, std::ceil(numobjects / 8.0), std::ceil(numverts / 32.0), 1);	//objects x number of vertices to pose
-			}
-		}, [&computeOffsetIndex, &values, this]() {
+			float offsets[4] = {static_cast<float>(computeOffsetIndex),0,0,0};
+			computeOffsetsUniform.SetValues(&offsets, 1);
+			
+			bgfx::setBuffer(1, poseStorageBuffer.GetHandle(), bgfx::Access::Read);
+			bgfx::dispatch(trackers.back().view, skinningShaderHandle, std::ceil(numobjects / 8.0), std::ceil(numverts / 32.0), 1);	//objects x number of vertices to pose
+		}
+		execdraw(bgfx::begin(), row, placement, [&computeOffsetIndex, &values, this](bgfx::Encoder* encoder) {
 			values[3] = static_cast<float>(computeOffsetIndex);
-			numRowsUniform.SetValues(&values, 1);
-			bgfx::setBuffer(11, skinningComputeBuffer.GetHandle(), bgfx::Access::Read);
-		});
+			numRowsUniform.SetValues(encoder, &values, 1);
+			encoder->setBuffer(11, skinningComputeBuffer.GetHandle(), bgfx::Access::Read);
+		}, trackers.back());
+	}
+	
+	if (opaquesRecorded){
+		opaquesRecorded->wait();
+	}
+	for(const auto& tracker : trackers){
+		drawStats.draws += tracker.stats.draws;
+		drawStats.programChanges += tracker.stats.programChanges;
+		drawStats.materialChanges += tracker.stats.materialChanges;
+		drawStats.meshChanges += tracker.stats.meshChanges;
 	}
 
 	// debug: draw the unified mesh
@@ -879,8 +977,7 @@ void RenderEngine::Draw(Ref<World> worldOwning){
    
     uint32_t shadowOffset = 0;
 	bgfx::ViewId currentShadowView = Views::LightingShadowsFirstView;
-	constexpr auto size = 20;
-	auto dlProjMtx = glm::ortho<float>(-size, size, -size, size, 0.5, 100);	// TODO: don't hardcode far clip
+	auto dlProjMtx = DirectionalLight::ShadowProjectionMatrix();
 	float shadowprojviewmtx[32]{0};
 
 	/**
@@ -919,7 +1016,7 @@ void RenderEngine::Draw(Ref<World> worldOwning){
 				const char* Lname = nullptr;
 				if constexpr (std::is_same_v<LightType, DirectionalLight>) {
 					Lname = "DL";
-					auto dirlightViewMat = glm::lookAt(vector3(l.rotation.x, l.rotation.y, l.rotation.z) * -25.f, vector3(0, 0, 0), vector3(0, 1, 0));
+					auto dirlightViewMat = DirectionalLight::ShadowViewMatrix(vector3(l.rotation.x, l.rotation.y, l.rotation.z));
 					//dirlightViewMat = glm::translate(dirlightViewMat, vector3(fd->viewmatrix[3][2], 0, fd->viewmatrix[3][0]));		// center the projection at the camera
 					copyMat4(glm::value_ptr(dirlightViewMat), lightViewMtx);
 					copyMat4(glm::value_ptr(dlProjMtx), shadowprojviewmtx);
@@ -0,0 +1,12 @@
+#include "StaticMesh.hpp"
+#include "World.hpp"
+
+using namespace RavEngine;
+
+void StaticMesh::QueueRegroup() const{
+    auto entity = GetOwner();
+    // InstancedStaticMeshes are not batched, and their owners may not have a StaticMesh
+    if (entity.IsInWorld() && entity.HasComponent<StaticMesh>()){
+        entity.MarkChanged<StaticMesh>();
+    }
+}
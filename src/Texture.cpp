@@ -73,6 +73,10 @@ void Texture::Bind(int id, const SamplerUniform &uniform){
 	bgfx::setTexture(id, uniform, texture);
 }
 
+void Texture::Bind(bgfx::Encoder* encoder, int id, const SamplerUniform &uniform){
+	encoder->setTexture(id, uniform, texture);
+}
+
 void Texture::CreateTexture(int width, int height, bool hasMipMaps, int numlayers, const uint8_t *data, int flags){
 	uint16_t numChannels = 4;	//TODO: allow n-channel textures
 	bgfx::TextureFormat::Enum format;
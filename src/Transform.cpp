@@ -2,11 +2,35 @@
 #include "mathtypes.hpp"
 #include <glm/gtc/type_ptr.hpp>
 #include "Common3D.hpp"
+#include "World.hpp"
 
 using namespace std;
 using namespace glm;
 using namespace RavEngine;
 
+void Transform::QueueChange() const{
+    auto entity = GetOwner();
+    if (auto world = entity.GetWorld()){
+        world->transformHierarchy.MarkChanged(owner);
+        // a Transform's constructor moves it before it is in the World, and new components are stamped anyway
+        const auto local_id = entity.GetIdInWorld();
+        if (world->HasComponent<Transform>(local_id)){
+            world->MarkChanged<Transform>(local_id);
+        }
+    }
+}
+
+bool Transform::CacheIsStale() const{
+    if (isDirty){
+        return true;
+    }
+    if (!HasParent()){
+        return false;
+    }
+    auto world = GetOwner().GetWorld();
+    return (world == nullptr || world->transformHierarchy.HasPendingChanges()) && HasDirtyParent();
+}
+
 Transform& Transform::AddChild(ComponentHandle<Transform> child)
 {
     auto cptr = child.get();
@@ -0,0 +1,223 @@
+#include "TransformHierarchy.hpp"
+#include "Transform.hpp"
+#include <ozz/base/maths/simd_math.h>
+
+using namespace std;
+using namespace RavEngine;
+
+void TransformSoA::resize(size_t count){
+    // round up so the last batch can be loaded whole
+    const auto padded = (count + simd_width - 1) / simd_width * simd_width;
+    for(int c = 0; c < 3; c++){
+        positions[c].resize(padded, 0);
+        scales[c].resize(padded, 1);
+        rotations[c].resize(padded, 0);
+    }
+    rotations[3].resize(padded, 1);
+}
+
+void RavEngine::ComputeLocalMatrices(const TransformSoA& soa, size_t begin, size_t end, matrix4* out){
+#if DOUBLE_PRECISION
+    ComputeLocalMatricesScalar(soa, begin, end, out);
+#else
+    using namespace ozz::math;
+    assert(begin % TransformSoA::simd_width == 0);
+    const SimdFloat4 zero = simd_float4::zero();
+    const SimdFloat4 one = simd_float4::one();
+    const SimdFloat4 two = one + one;
+    for(size_t i = begin; i < end; i += TransformSoA::simd_width){
+        auto load = [i](const Vector<float>& values){
+            return simd_float4::LoadPtrU(values.data() + i);
+        };
+        const SimdFloat4 x = load(soa.rotations[0]), y = load(soa.rotations[1]), z = load(soa.rotations[2]), w = load(soa.rotations[3]);
+        const SimdFloat4 sx = load(soa.scales[0]), sy = load(soa.scales[1]), sz = load(soa.scales[2]);
+        const SimdFloat4 xx = x * x, xy = x * y, xz = x * z, xw = x * w;
+        const SimdFloat4 yy = y * y, yz = y * z, yw = y * w;
+        const SimdFloat4 zz = z * z, zw = z * w;
+        
+        // column-major, with one lane per transform
+        const SimdFloat4 cols[4][4] = {
+            {sx * (one - two * (yy + zz)), sx * two * (xy + zw), sx * two * (xz - yw), zero},
+            {sy * two * (xy - zw), sy * (one - two * (xx + zz)), sy * two * (yz + xw), zero},
+            {sz * two * (xz + yw), sz * two * (yz - xw), sz * (one - two * (xx + yy)), zero},
+            {load(soa.positions[0]), load(soa.positions[1]), load(soa.positions[2]), one}
+        };
+        const auto n = std::min(TransformSoA::simd_width, end - i);
+        for(int c = 0; c < 4; c++){
+            SimdFloat4 lanes[4];
+            Transpose4x4(cols[c], lanes);     // lanes[k] is now column c of transform i + k
+            for(size_t k = 0; k < n; k++){
+                StorePtrU(lanes[k], &out[i + k][c][0]);
+            }
+        }
+    }
+#endif
+}
+
+void RavEngine::ComputeLocalMatricesScalar(const TransformSoA& soa, size_t begin, size_t end, matrix4* out){
+    for(size_t i = begin; i < end; i++){
+        const vector3 position(soa.positions[0][i], soa.positions[1][i], soa.positions[2][i]);
+        const quaternion rotation(soa.rotations[3][i], soa.rotations[0][i], soa.rotations[1][i], soa.rotations[2][i]);
+        const vector3 scale(soa.scales[0][i], soa.scales[1][i], soa.scales[2][i]);
+        out[i] = glm::translate(matrix4(1), position) * glm::toMat4(rotation) * glm::scale(matrix4(1), scale);
+    }
+}
+
+void TransformHierarchy::Rebuild(Transform* newData, size_t newCount){
+    // dense index of each Transform's parent
+    auto& denseIndexOf = nodeOfOwner;     // reused for the node index of each owner below
+    denseIndexOf.clear();
+    denseIndexOf.reserve(newCount);
+    for(uint32_t i = 0; i < newCount; i++){
+        denseIndexOf[newData[i].owner] = i;
+    }
+    Vector<uint32_t> denseParents(newCount);
+    for(uint32_t i = 0; i < newCount; i++){
+        denseParents[i] = no_parent;
+        if (newData[i].parent.IsValid()){
+            auto it = denseIndexOf.find(newData[i].parent.get_id());
+            denseParents[i] = it != denseIndexOf.end() ? it->second : external_parent;
+        }
+    }
+
+    // depth of each Transform, remembering the depths found along the way
+    constexpr uint32_t unknown = no_parent;
+    Vector<uint32_t> depths(newCount, unknown), chain;
+    uint32_t maxDepth = 0;
+    for(uint32_t i = 0; i < newCount; i++){
+        chain.clear();
+        auto j = i;
+        while(j < external_parent && depths[j] == unknown){
+            chain.push_back(j);
+            j = denseParents[j];
+        }
+        uint32_t depth = j < external_parent ? depths[j] + 1 : 0;
+        for(auto it = chain.rbegin(); it != chain.rend(); ++it){
+            depths[*it] = depth++;
+        }
+        maxDepth = std::max(maxDepth, depths[i]);
+    }
+
+    // counting sort by depth
+    Vector<uint32_t> offsets(maxDepth + 2, 0);
+    for(auto depth : depths){
+        offsets[depth + 1]++;
+    }
+    for(uint32_t d = 1; d < offsets.size(); d++){
+        offsets[d] += offsets[d-1];
+    }
+    Vector<uint32_t> nodeOf(newCount);
+    for(uint32_t i = 0; i < newCount; i++){
+        nodeOf[i] = offsets[depths[i]]++;
+    }
+
+    locals.resize(newCount);
+    worldMatrices.resize(newCount);
+    worldRotations.resize(newCount);
+    parents.resize(newCount);
+    parentOwners.resize(newCount);
+    dirty.assign(newCount, 1);
+    transforms.resize(newCount);
+    for(uint32_t i = 0; i < newCount; i++){
+        auto node = nodeOf[i];
+        auto& t = newData[i];
+        transforms[node] = &t;
+        locals.Set(node, t.position, t.rotation, t.scale);
+        parentOwners[node] = t.parent.get_id();
+        parents[node] = denseParents[i] < external_parent ? nodeOf[denseParents[i]] : denseParents[i];
+    }
+    for(auto& pair : nodeOfOwner){
+        pair.second = nodeOf[pair.second];
+    }
+    // a Transform below one in another World cannot be computed here either
+    for(uint32_t node = 0; node < newCount; node++){
+        if (parents[node] < external_parent && parents[parents[node]] == external_parent){
+            parents[node] = external_parent;
+        }
+    }
+
+    data = newData;
+    count = newCount;
+}
+
+void TransformHierarchy::Update(Transform* newData, size_t newCount, size_t newGeneration){
+    bool rebuild = newData != data || newCount != count || newGeneration != generation;
+    generation = newGeneration;
+
+    changedBatch.clear();
+    entity_t owner;
+    while(changed.try_dequeue(owner)){
+        changedBatch.push_back(owner);
+    }
+    pendingChanges.store(0, std::memory_order_relaxed);
+
+    // gather the local values of the Transforms that changed
+    if (!rebuild){
+        std::fill(dirty.begin(), dirty.end(), 0);
+        for(const auto owner : changedBatch){
+            auto it = nodeOfOwner.find(owner);
+            if (it == nodeOfOwner.end()){
+                continue;   // no longer in this World
+            }
+            const auto i = it->second;
+            auto t = transforms[i];
+            // reparenting always marks the child, so only queued Transforms can have moved in the hierarchy
+            if (t->parent.get_id() != parentOwners[i]){
+                rebuild = true;
+                break;
+            }
+            dirty[i] = 1;
+            locals.Set(i, t->position, t->rotation, t->scale);
+        }
+    }
+    if (rebuild){
+        Rebuild(newData, newCount);
+    }
+    else{
+        // parents come first, so one pass carries changes down to every descendant
+        for(uint32_t i = 0; i < transforms.size(); i++){
+            if (parents[i] < external_parent && dirty[parents[i]]){
+                dirty[i] = 1;
+            }
+        }
+    }
+
+    // local matrices for every batch with a dirty Transform in it, simd_width at a time
+    constexpr auto width = TransformSoA::simd_width;
+    const auto n = transforms.size();
+    dirtyBatches.resize((n + width - 1) / width);
+    for(size_t b = 0; b < dirtyBatches.size(); b++){
+        const auto begin = b * width, end = std::min(n, begin + width);
+        dirtyBatches[b] = std::any_of(dirty.begin() + begin, dirty.begin() + end, [](uint8_t d){
+            return d != 0;
+        });
+        if (dirtyBatches[b]){
+            ComputeLocalMatrices(locals, begin, end, worldMatrices.data());
+        }
+    }
+    
+    moved.clear();
+    // parents come first, so their world matrices are final by the time their children read them.
+    // A clean Transform recomputed because it shares a batch has a clean parent, so this still gives its old matrix.
+    for(uint32_t i = 0; i < n; i++){
+        if (!dirtyBatches[i / width] || parents[i] == external_parent){
+            continue;
+        }
+        const quaternion localRotation(locals.rotations[3][i], locals.rotations[0][i], locals.rotations[1][i], locals.rotations[2][i]);
+        if (parents[i] != no_parent){
+            worldMatrices[i] = worldMatrices[parents[i]] * worldMatrices[i];
+            worldRotations[i] = worldRotations[parents[i]] * localRotation;
+        }
+        else{
+            worldRotations[i] = localRotation;
+        }
+        if (dirty[i]){
+            auto t = transforms[i];
+            t->matrix = worldMatrices[i];
+            t->worldPosition = vector3(worldMatrices[i][3]);
+            t->worldRotation = worldRotations[i];
+            t->isDirty = false;
+            moved.push_back(t->owner);
+        }
+    }
+}
@@ -43,13 +43,74 @@ void RavEngine::World::Tick(float scale) {
 	
 	//Tick the game code
 	TickECS(scale);
+    
+    // apply structural changes that Systems deferred
+    PlaybackCommands();
 
     PostTick(scale);
 }
 
+size_t World::WorkerSlot(){
+    // this_worker_id is -1 for threads outside the executor. Without an App, every thread gets slot 0.
+    auto app = GetApp();
+    return app != nullptr ? app->executor.this_worker_id() + 1 : 0;
+}
+
+World::CommandBuffer& World::GetCommandBuffer(){
+    return commandBuffers[WorkerSlot()];
+}
+
+void World::PlaybackCommands(){
+    for(auto& buffer : commandBuffers){
+        for(auto& command : buffer.commands){
+            commandBatch.push_back(std::move(command));
+        }
+        buffer.commands.clear();
+    }
+    if (commandBatch.empty()){
+        return;
+    }
+    
+    // group component changes by type so each type's storage is touched in one run.
+    // stable, so changes to the same type keep the order they were recorded in
+    std::stable_sort(commandBatch.begin(), commandBatch.end(), [](const CommandBuffer::Command& a, const CommandBuffer::Command& b){
+        return a.kind != b.kind ? a.kind < b.kind : a.type < b.type;
+    });
+    
+    // find the targets before anything is created, because a new entity can reuse the id of one destroyed since recording
+    commandTargets.clear();
+    for(const auto& command : commandBatch){
+        const bool inThisWorld = command.kind != CommandBuffer::Kind::Create && Registry::IsInWorld(command.global_id) && Registry::GetWorld(command.global_id) == this;
+        commandTargets.push_back(inThisWorld ? Registry::GetLocalId(command.global_id) : INVALID_ENTITY);
+    }
+    
+    for(size_t i = 0; i < commandBatch.size(); i++){
+        auto& command = commandBatch[i];
+        if (command.kind == CommandBuffer::Kind::Create){
+            command.fn(this, INVALID_ENTITY);
+            continue;
+        }
+        // the entity was destroyed or moved to another world since this was recorded
+        if (commandTargets[i] == INVALID_ENTITY){
+            continue;
+        }
+        if (command.kind == CommandBuffer::Kind::Component){
+            command.fn(this, commandTargets[i]);
+        }
+        else if (Registry::IsInWorld(command.global_id)){     // it may be destroyed twice in one batch
+            Registry::DestroyEntity(command.global_id);
+        }
+    }
+    commandBatch.clear();
+}
+
 
 RavEngine::World::World(){
+    numWorkers = GetApp() != nullptr ? static_cast<pos_t>(GetApp()->executor.num_workers()) : 1;
+    commandBuffers.resize(numWorkers + 1);
+    renderBuckets.resize(numWorkers + 1);
     SetupTaskGraph();
+    // Systems sharing component types are ordered by registration, the explicit dependencies cover the rest
     EmplacePolymorphicSystem<ScriptSystem,ScriptComponent>();
     EmplaceSystem<AnimatorSystem,AnimatorComponent>();
 	EmplaceSystem<SocketSystem,SocketConstraint,Transform>();
@@ -127,8 +188,14 @@ void World::SetupTaskGraph(){
     ECSTasks.name("ECS");
     ECSTaskModule = masterTasks.composed_of(ECSTasks).name("ECS");
     
+    // recalculate world matrices once, after Systems move things and before anything reads them
+    auto transformUpdate = masterTasks.emplace([this]{
+        UpdateTransforms();
+    }).name("Transform hierarchy");
+    transformUpdate.succeed(ECSTaskModule);
+    
     // ensure Systems run before rendering
-    renderTaskModule.succeed(ECSTaskModule);
+    renderTaskModule.succeed(transformUpdate);
     
     // process any dispatched coroutines
     auto updateAsyncIterators = masterTasks.emplace([&]{
@@ -158,8 +225,9 @@ void World::SetupTaskGraph(){
 			Solver.Tick(GetCurrentFPSScale());
 		}).name("PhysX Tick");
     
-        auto read = EmplaceSystem<PhysicsLinkSystemRead, RigidBodyDynamicComponent,Transform>(Solver.scene);
+        // both touch Transform, so the write is added first to be ordered before the read
         auto write = EmplacePolymorphicSystem<PhysicsLinkSystemWrite, PhysicsBodyComponent,Transform>(Solver.scene);
+        auto read = EmplaceSystem<PhysicsLinkSystemRead, RigidBodyDynamicComponent,Transform>(Solver.scene);
         RunPhysics.precede(read.second);
 		RunPhysics.succeed(write.second);
 	//}
@@ -167,6 +235,11 @@ void World::SetupTaskGraph(){
     // setup audio tasks
     audioTasks.name("Audio");
     
+    // these tasks run in parallel, so create their groups now rather than on the first frame
+    RegisterQuery<AudioListener,Transform>();
+    RegisterQuery<AudioSourceComponent,Transform>();
+    RegisterQuery<AudioRoom,Transform>();
+    
     auto audioClear = audioTasks.emplace([this]{
         GetApp()->GetCurrentAudioSnapshot()->Clear();
         //TODO: currently this selects the LAST listener, but there is no need for this
@@ -198,7 +271,7 @@ void World::SetupTaskGraph(){
     }).name("Point Audios").succeed(audioClear);
     
     auto copyAmbients = audioTasks.emplace([this]{
-        if(componentMap.contains(CTTI<AmbientAudioSourceComponent>())){
+        if(GetSetErased<AmbientAudioSourceComponent>() != nullptr){
             auto fn = [this](float, auto& audioSource){
                 GetApp()->GetCurrentAudioSnapshot()->ambientSources.emplace_back(audioSource.GetPlayer());
             };
@@ -231,7 +304,111 @@ void World::SetupTaskGraph(){
     }).name("Swap Current").succeed(copyAudios,copyAmbients,copyRooms);
     
     audioTaskModule = masterTasks.composed_of(audioTasks).name("Audio");
-    audioTaskModule.succeed(ECSTaskModule);
+    audioTaskModule.succeed(transformUpdate);
+}
+
+void World::UpdateTransforms(){
+    auto erased = GetSetErased<Transform>();
+    if (erased != nullptr && erased->GetSet<Transform>()->DenseSize() > 0){
+        auto set = erased->GetSet<Transform>();
+        transformHierarchy.Update(&set->Get(0), set->DenseSize(), set->Generation());
+    }
+    else{
+        transformHierarchy.Update(nullptr, 0, 0);
+    }
+}
+
+void World::UpdateStaticBatches(){
+    auto staticmeshes = GetAllComponentsOfType<StaticMesh>();
+    if (!staticmeshes){
+        return;
+    }
+    auto set = staticmeshes.value();
+    
+    // removed StaticMeshes do not show up in the change scan, so look for them when the set's contents change
+    if (set->Generation() != staticBatchGeneration){
+        staticBatchGeneration = set->Generation();
+        for(const auto& batch : staticBatches.GetBatches()){
+            for(auto s = batch.members.size(); s > 0; s--){
+                if (!set->HasComponent(batch.members[s-1])){
+                    staticBatches.Remove(batch.members[s-1]);
+                    staticGeometryStale = true;
+                }
+            }
+        }
+    }
+    
+    // added StaticMeshes are stamped as changed, as are ones enabled, disabled or given a new material
+    const auto since = set->BeginChangeScan(staticBatchCursor);
+    for(entity_t i = 0; i < set->DenseSize(); i++){
+        if (!set->ChangedSince(i, since)){
+            continue;
+        }
+        const auto& mesh = set->Get(i);
+        const auto local_id = set->GetOwner(i);
+        const auto current = staticBatches.BatchOf(local_id);
+        if (!mesh.Enabled){
+            if (current != INVALID_INDEX){
+                staticBatches.Remove(local_id);
+                staticGeometryStale = true;
+            }
+            continue;
+        }
+        const static_batch_key_t key = mesh.getTuple();
+        if (current != INVALID_INDEX){
+            if (staticBatches.GetBatches()[current].key == key){
+                continue;
+            }
+            staticBatches.Remove(local_id);
+        }
+        staticBatches.Add(local_id, key);
+        staticGeometryStale = true;
+    }
+}
+
+void World::UpdateStaticGeometry(){
+    auto staticmeshes = GetAllComponentsOfType<StaticMesh>();
+    if (!staticmeshes){
+        return;
+    }
+    auto set = staticmeshes.value();
+    auto worldBounds = [set](entity_t local_id){
+        const auto& mesh = set->GetComponent(local_id);
+        vector3 center, extent;
+        Frustum::TransformBounds(mesh.GetOwner().GetTransform().CalculateWorldMatrix(), mesh.getMesh()->GetBounds(), center, extent);
+        return AABB::FromCenterExtent(center, extent);
+    };
+    
+    if (staticGeometryStale){
+        staticGeometryStale = false;
+        for(auto owner : staticGeometryItems){
+            staticGeometryItemOf.erase(owner);
+        }
+        staticGeometryItems.clear();
+        Vector<AABB> bounds;
+        for(const auto& batch : staticBatches.GetBatches()){
+            for(auto local_id : batch.members){
+                staticGeometryItemOf.set(localToGlobal[local_id], static_cast<pos_t>(staticGeometryItems.size()));
+                staticGeometryItems.push_back(localToGlobal[local_id]);
+                bounds.push_back(worldBounds(local_id));
+            }
+        }
+        staticGeometry.Build(bounds.data(), bounds.size());
+        return;
+    }
+    
+    // only the meshes that moved this frame need new bounds
+    bool moved = false;
+    for(auto owner : transformHierarchy.GetMoved()){
+        const auto item = staticGeometryItemOf.get(owner);
+        if (item != INVALID_INDEX){
+            staticGeometry.Update(item, worldBounds(Registry::GetLocalId(owner)));
+            moved = true;
+        }
+    }
+    if (moved){
+        staticGeometry.Refit();
+    }
 }
 
 void World::setupRenderTasks(){
@@ -240,6 +417,13 @@ void World::setupRenderTasks(){
     renderTasks.name("Render");
     
 	auto camproc = renderTasks.emplace([this](){
+        culling.camera = Frustum();
+        culledObjects = 0;
+        submittedObjects = 0;
+        culledLights = 0;
+        submittedLights = 0;
+        culledShadowCasters = 0;
+        submittedShadowCasters = 0;
         if (auto allcams = GetAllComponentsOfType<CameraComponent>()){
             for (auto& cam : *allcams.value()) {
                 if (cam.IsActive()) {
@@ -249,7 +433,10 @@ void World::setupRenderTasks(){
                     auto current = GetApp()->GetCurrentFramedata();
                     current->viewmatrix = cam.GenerateViewMatrix();
                     current->projmatrix = cam.GenerateProjectionMatrix();
+                    current->nearClip = cam.nearClip;
+                    current->farClip = cam.farClip;
                     current->cameraWorldpos = cam.GetOwner().GetTransform().GetWorldPosition();
+                    culling.camera = Frustum(current->projmatrix * current->viewmatrix);
 
                     break;
                 }
@@ -287,53 +474,93 @@ void World::setupRenderTasks(){
 
 	}).name("Init iterators");
 	
-	//sort into the hashmap
-    auto sort = renderTasks.emplace([this]{
+    // static meshes write straight into the frame data, into slots given out by their persistent batches.
+    // The other kinds extract into per-thread buckets, which are merged into the frame data once all of them finish.
+    auto sort = renderTasks.emplace([this](tf::Subflow& sf){
+        UpdateStaticBatches();
+        UpdateStaticGeometry();
         auto current = GetApp()->GetCurrentFramedata();
-        auto staticmeshes = GetAllComponentsOfType<StaticMesh>();
-        if (staticmeshes){
-            for(const auto& e : *staticmeshes.value()){
-                if (e.Enabled) {
-                    auto& pair = e.getTuple();
-                    auto mat = e.GetOwner().GetTransform().CalculateWorldMatrix();
-                    auto& item = current->opaques[pair];
-                    item.AddItem(mat);
-                }
+        const auto total = staticBatches.Layout();
+        if (total == 0){
+            return;
+        }
+        auto set = GetAllComponentsOfType<StaticMesh>().value();
+        
+        // the hierarchy rejects whole groups of meshes at once
+        staticVisible.assign(total, 0);
+        auto markVisible = [this,set](uint32_t item){
+            const auto local_id = Registry::GetLocalId(staticGeometryItems[item]);
+            // meshes hidden by writing Enabled rather than with SetEnabled are still batched, so skip them here
+            if (!set->GetComponent(local_id).Enabled){
+                return false;
+            }
+            staticVisible[staticBatches.FlatIndex(local_id)] = 1;
+            return true;
+        };
+        staticGeometry.QueryFrustum(culling.camera, markVisible);
+        
+        // casters the camera cannot see still need to reach the shadow maps of the lights they are inside
+        uint32_t castersFound = 0;
+        auto markCaster = [&markVisible, &castersFound](uint32_t item){
+            castersFound += markVisible(item);
+        };
+        for(const auto& volume : culling.shadowFrusta){
+            staticGeometry.QueryFrustum(volume, markCaster);
+        }
+        for(const auto& volume : culling.shadowBoxes){
+            staticGeometry.QueryBox(volume, markCaster);
+        }
+        const auto castersTested = static_cast<uint32_t>(total * culling.NumShadowVolumes());
+        submittedShadowCasters.fetch_add(castersFound, std::memory_order_relaxed);
+        culledShadowCasters.fetch_add(castersTested - castersFound, std::memory_order_relaxed);
+        
+        // claim output only for the meshes that were kept, so culled ones take no instance memory
+        staticBatchOutputs.clear();
+        staticOutputSlot.resize(total);
+        pos_t n_visible = 0;
+        const auto& batches = staticBatches.GetBatches();
+        for(pos_t b = 0; b < batches.size(); b++){
+            const auto offset = staticBatches.Offset(b);
+            const auto kept = staticBatches.PackedPositions(staticVisible.data() + offset, staticOutputSlot.data() + offset, batches[b].members.size());
+            n_visible += kept;
+            if (kept == 0){
+                staticBatchOutputs.push_back(nullptr);
+                continue;
+            }
+            // write into the GPU's instance memory when there is room, so that drawing does not copy the matrices again
+            auto& row = current->opaques[batches[b].key];
+            const auto first = current->instanceArena.Allocate(kept);
+            if (first != INVALID_INDEX){
+                row.arenaFirst = first;
+                row.arenaCount = kept;
+                staticBatchOutputs.push_back(current->instanceArena.Get(first));
+            }
+            else{
+                row.items.resize(kept);
+                staticBatchOutputs.push_back(row.items.data());
             }
         }
-    }).name("sort static serial");
-//	auto sort = renderTasks.for_each(std::ref(geobegin),std::ref(geoend),[&](const StaticMesh& e){
-//		auto current = GetApp()->GetCurrentFramedata();
-//        if (e.Enabled) {
-//            auto& pair = e.getTuple();
-//            auto mat = e.GetOwner().GetTransform().CalculateWorldMatrix();
-//            auto& item = current->opaques[pair];
-//            item.AddItem(mat);
-//        }
-//	}).name("sort static");
-//	auto sortskinned = renderTasks.for_each(std::ref(skinnedgeobegin), std::ref(skinnedgeoend), [&](const SkinnedMeshComponent& m){
-//        if (m.Enabled) {
-//            auto& pair = m.getTuple();
-//            auto mat = m.GetOwner().GetTransform().CalculateWorldMatrix();
-//            auto current = GetApp()->GetCurrentFramedata();
-//            auto& item = current->skinnedOpaques[pair];
-//            item.AddItem(mat);
-//            // write the pose if there is one
-//            if (m.GetOwner().HasComponent<AnimatorComponent>()) {
-//                auto& animator = m.GetOwner().GetComponent<AnimatorComponent>();
-//                item.AddSkinningData(animator.GetSkinningMats());
-//            }
-//        }
-//	}).name("sort skinned");
-    auto sortskinned = renderTasks.emplace([this]{
+        submittedObjects.fetch_add(n_visible, std::memory_order_relaxed);
+        culledObjects.fetch_add(total - n_visible, std::memory_order_relaxed);
+        
+        ForEachWithPolicy(sf, total, staticExtraction, [this,set](pos_t i){
+            if (!staticVisible[i]){
+                return;
+            }
+            const auto [b, slot] = staticBatches.Locate(i);
+            const auto& mesh = set->GetComponent(staticBatches.GetBatches()[b].members[slot]);
+            staticBatchOutputs[b][staticOutputSlot[i]] = mesh.GetOwner().GetTransform().CalculateWorldMatrix();
+        });
+    }).name("sort static");
+    auto sortskinned = renderTasks.emplace([this](tf::Subflow& sf){
         auto skinneds = GetAllComponentsOfType<SkinnedMeshComponent>();
         if (skinneds){
-            for(const auto& m : *skinneds.value()){
+            auto set = skinneds.value();
+            ForEachWithPolicy(sf, static_cast<pos_t>(set->DenseSize()), skinnedExtraction, [this,set](pos_t i){
+                const auto& m = set->Get(i);
                 if (m.Enabled) {
-                    auto& pair = m.getTuple();
                     auto mat = m.GetOwner().GetTransform().CalculateWorldMatrix();
-                    auto current = GetApp()->GetCurrentFramedata();
-                    auto& item = current->skinnedOpaques[pair];
+                    auto& item = renderBuckets[WorkerSlot()].skinnedOpaques[m.getTuple()];
                     item.AddItem(mat);
                     // write the pose if there is one
                     if (m.GetOwner().HasComponent<AnimatorComponent>()) {
@@ -341,50 +568,67 @@ void World::setupRenderTasks(){
                         item.AddSkinningData(animator.GetSkinningMats());
                     }
                 }
-            }
+            });
         }
-    }).name("sort skinned serial");
-//    auto sortInstanced = renderTasks.for_each(std::ref(instancedBegin), std::ref(instancedEnd), [&](const InstancedStaticMesh& m){
-//        auto current = GetApp()->GetCurrentFramedata();
-//        if (m.Enabled){
-//            auto& pair = m.getTuple();
-//            m.CalculateMatrices();
-//            auto& mats = m.GetAllTransforms();
-//
-//            auto& item = current->opaques[pair];
-//            item.mtx.lock();
-//            item.items.insert(item.items.end(), mats.begin(),mats.end());
-//            item.mtx.unlock();
-//        }
-//    }).name("sort instanced");
-    auto sortInstanced = renderTasks.emplace([this]{
-        auto current = GetApp()->GetCurrentFramedata();
+    }).name("sort skinned");
+    auto sortInstanced = renderTasks.emplace([this](tf::Subflow& sf){
         auto instanced = GetAllComponentsOfType<InstancedStaticMesh>();
         if (instanced){
-            for(const auto& m : *instanced.value()){
+            auto set = instanced.value();
+            ForEachWithPolicy(sf, static_cast<pos_t>(set->DenseSize()), instancedExtraction, [this,set](pos_t i){
+                const auto& m = set->Get(i);
                 if (m.Enabled){
-                    auto& pair = m.getTuple();
                     m.CalculateMatrices();
                     auto& mats = m.GetAllTransforms();
-
-                    auto& item = current->opaques[pair];
-                    //item.mtx.lock();
-                    item.items.insert(item.items.end(), mats.begin(),mats.end());
-                    //item.mtx.unlock();
+                    auto& items = renderBuckets[WorkerSlot()].opaques[m.getTuple()].items;
+                    const auto& bounds = m.getMesh()->GetBounds();
+                    constexpr auto width = Frustum::simd_width;
+                    vector3 centers[width], extents[width];
+                    uint32_t kept = 0, castersFound = 0;
+                    for(size_t begin = 0; begin < mats.size(); begin += width){
+                        const auto count = std::min(width, mats.size() - begin);
+                        for(size_t k = 0; k < count; k++){
+                            Frustum::TransformBounds(mats[begin + k], bounds, centers[k], extents[k]);
+                        }
+                        const auto visible = culling.TestBoxes(centers, extents, count, castersFound);
+                        for(size_t k = 0; k < count; k++){
+                            if (visible & (1u << k)){
+                                items.push_back(mats[begin + k]);
+                                kept++;
+                            }
+                        }
+                    }
+                    const auto n = static_cast<uint32_t>(mats.size());
+                    const auto castersTested = static_cast<uint32_t>(n * culling.NumShadowVolumes());
+                    submittedObjects.fetch_add(kept, std::memory_order_relaxed);
+                    culledObjects.fetch_add(n - kept, std::memory_order_relaxed);
+                    submittedShadowCasters.fetch_add(castersFound, std::memory_order_relaxed);
+                    culledShadowCasters.fetch_add(castersTested - castersFound, std::memory_order_relaxed);
                 }
-            }
+            });
+        }
+    }).name("sort instanced");
+    auto mergeBuckets = renderTasks.emplace([this]{
+        auto current = GetApp()->GetCurrentFramedata();
+        current->culledObjects = culledObjects;
+        current->submittedObjects = submittedObjects;
+        current->culledShadowCasters = culledShadowCasters;
+        current->submittedShadowCasters = submittedShadowCasters;
+        for(auto& bucket : renderBuckets){
+            FrameData::MergeBucket(bucket.opaques, current->opaques);
+            FrameData::MergeBucket(bucket.skinnedOpaques, current->skinnedOpaques);
         }
-    }).name("sort instanced - serial");
+    }).name("merge render buckets");
+    mergeBuckets.succeed(sort, sortskinned, sortInstanced);
 
 	init.precede(sort,sortskinned,sortInstanced);
-    sort.precede(sortInstanced);    // because these write to the same container
 
 	auto copydirs = renderTasks.emplace([this](){
         if (auto dirs = GetAllComponentsOfType<DirectionalLight>()){
             auto ptr = dirs.value();
             for(int i = 0; i < ptr->DenseSize(); i++){
                 auto owner = Entity(ptr->GetOwner(i));
-                auto rot = owner.GetTransform().Up();
+                auto rot = DirectionalLight::Direction(owner.GetTransform());
                 FrameData::PackedDL::tinyvec3 r{
                     static_cast<float>(rot.x),
                     static_cast<float>(rot.y),
@@ -413,7 +657,13 @@ void World::setupRenderTasks(){
                 auto transform = owner.GetTransform().CalculateWorldMatrix();
                 auto current = GetApp()->GetCurrentFramedata();
                 const auto& l = ptr->Get(i);
-                current->AddLight(current->spots,l,l.CalculateMatrix(transform));
+                const auto lightMatrix = l.CalculateMatrix(transform);
+                if (!culling.LightVisible(l, lightMatrix)){
+                    culledLights++;
+                    continue;
+                }
+                submittedLights++;
+                current->AddLight(current->spots,l,lightMatrix);
             }
         }
 
@@ -426,12 +676,44 @@ void World::setupRenderTasks(){
                 const auto& d = ptr->Get(i);
                 auto transform = owner.GetTransform().CalculateWorldMatrix();
                 auto current = GetApp()->GetCurrentFramedata();
-                current->AddLight(current->points,d,d.CalculateMatrix(transform));
+                const auto lightMatrix = d.CalculateMatrix(transform);
+                if (!culling.LightVisible(d, lightMatrix)){
+                    culledLights++;
+                    continue;
+                }
+                submittedLights++;
+                current->AddLight(current->points,d,lightMatrix);
             }
         }
 
 	}).name("copypoints");
 
+	auto shadowVolumes = renderTasks.emplace([this](){
+        culling.ClearShadowVolumes();
+        if (auto dirs = GetAllComponentsOfType<DirectionalLight>()){
+            auto ptr = dirs.value();
+            for(int i = 0; i < ptr->DenseSize(); i++){
+                if (ptr->Get(i).CastsShadows()){
+                    culling.AddShadowVolume(ptr->Get(i), DirectionalLight::Direction(Entity(ptr->GetOwner(i)).GetTransform()));
+                }
+            }
+        }
+        auto addVolumes = [this](auto set){
+            for(int i = 0; i < set->DenseSize(); i++){
+                const auto& l = set->Get(i);
+                if (l.CastsShadows()){
+                    culling.AddShadowVolume(l, Entity(set->GetOwner(i)).GetTransform().CalculateWorldMatrix());
+                }
+            }
+        };
+        if (auto points = GetAllComponentsOfType<PointLight>()){
+            addVolumes(points.value());
+        }
+        if (auto spots = GetAllComponentsOfType<SpotLight>()){
+            addVolumes(spots.value());
+        }
+	}).name("Shadow volumes");
+
 	auto tickGUI = renderTasks.emplace([this]() {
         // also do the time here
         GetApp()->GetCurrentFramedata()->Time = GetApp()->GetCurrentTime();
@@ -456,14 +738,22 @@ void World::setupRenderTasks(){
 		auto current = GetApp()->GetCurrentFramedata();
 		current->Clear();
 	}).name("Clear-setup");
-	setup.precede(camproc, copydirs,copyambs,copyspots,copypoints,tickGUI);
-	sort.precede(swap);
-	sortskinned.precede(swap);
-    sortInstanced.precede(swap);
-	camproc.precede(sort,sortskinned);
+	setup.precede(camproc, copydirs,copyambs,copyspots,copypoints,shadowVolumes,tickGUI);
+	mergeBuckets.precede(swap);
+	camproc.precede(sort,sortskinned,sortInstanced,copyspots,copypoints);
+	shadowVolumes.precede(sort,sortInstanced);
 
 	swap.succeed(camproc,copydirs,copyambs,copyspots,copypoints,tickGUI);
     
+    // the light counts are final once both light types are copied
+    auto lightStats = renderTasks.emplace([this]{
+        auto current = GetApp()->GetCurrentFramedata();
+        current->culledLights = culledLights;
+        current->submittedLights = submittedLights;
+    }).name("Light stats");
+    lightStats.succeed(copyspots,copypoints);
+    lightStats.precede(swap);
+    
     // attatch the renderTasks module to the masterTasks
     renderTaskModule = masterTasks.composed_of(renderTasks).name("Render");
 }
@@ -489,6 +779,61 @@ entity_t World::CreateEntity(){
     return localToGlobal[id];
 }
 
+World::EntityBatch World::CreateEntities(entity_t count){
+    EntityBatch batch;
+    batch.count = count;
+    batch.firstLocal = static_cast<entity_t>(localToGlobal.size());
+    batch.firstGlobal = Registry::CreateEntities(this, batch.firstLocal, count);
+    localToGlobal.reserve(localToGlobal.size() + count);
+    for(entity_t i = 0; i < count; i++){
+        localToGlobal.push_back(batch.firstGlobal + i);
+    }
+    componentMasks.resize(localToGlobal.size() * maskWords, 0);
+    return batch;
+}
+
+void World::DestroyEntities(const entity_t* global_ids, size_t count){
+    Vector<entity_t> local_ids;
+    local_ids.reserve(count);
+    for(size_t i = 0; i < count; i++){
+        assert(Registry::GetWorld(global_ids[i]) == this);
+        local_ids.push_back(Registry::GetLocalId(global_ids[i]));
+        NetworkingDestroy(local_ids.back());
+        chunkedComponents.DestroyEntity(local_ids.back());
+    }
+    
+    // find every type present in the batch, then remove one type at a time from all the entities that have it
+    Vector<uint64_t> present(maskWords, 0);
+    for(const auto local_id : local_ids){
+        for(uint32_t w = 0; w < maskWords; w++){
+            auto word = size_t(local_id) * maskWords + w;
+            if (word < componentMasks.size()){
+                present[w] |= componentMasks[word];
+            }
+        }
+    }
+    for(uint32_t w = 0; w < maskWords; w++){
+        auto bits = present[w];
+        while (bits != 0){
+            auto bit = CountTrailingZeros(bits);
+            bits &= bits - 1;
+            auto set = componentSets[w * 64 + bit].load(std::memory_order_relaxed);
+            for(const auto local_id : local_ids){
+                auto word = size_t(local_id) * maskWords + w;
+                if (word < componentMasks.size() && (componentMasks[word] & (uint64_t(1) << bit))){
+                    set->vtable->destroyFn(set, local_id, this);
+                }
+            }
+        }
+    }
+    
+    for(size_t i = 0; i < count; i++){
+        available.push(local_ids[i]);
+        localToGlobal[local_ids[i]] = INVALID_ENTITY;
+        Registry::ReleaseEntity(global_ids[i]);
+    }
+}
+
 World::~World() {
     for(entity_t i = 0; i < localToGlobal.size(); i++){
         if (EntityIsValid(localToGlobal[i])){
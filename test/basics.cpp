@@ -7,7 +7,18 @@
 #include <iostream>
 #include <functional>
 #include <RavEngine/Uuid.hpp>
+#include <RavEngine/GameObject.hpp>
+#include <RavEngine/Frustum.hpp>
+#include <RavEngine/BVH.hpp>
+#include <RavEngine/LightClusters.hpp>
+#include <RavEngine/LightCulling.hpp>
+#include <RavEngine/FrameData.hpp>
+#include <RavEngine/DrawSortKey.hpp>
+#include <RavEngine/ExecutionPolicy.hpp>
+#include <RavEngine/StaticBatches.hpp>
+#include <bgfx/bgfx.h>
 #include <string_view>
+#include <random>
 
 using namespace RavEngine;
 using namespace std;
@@ -163,6 +174,14 @@ int Test_SpawnDestroy(){
        cout << "After destroying " << iend-ibegin << " 2-component entities, filter yields " << icount << " intcomponents and " << fcount << " floatcomponents\n";
        assert(icount == (entities.size() - (iend - ibegin )));
        assert(fcount == (entities.size() - (iend - ibegin)));
+       
+       // multi-type filters go through a query group, which must have dropped the destroyed entities
+       int bothcount = 0;
+       auto fboth = [&](float,auto& ic, auto& fc) {
+           bothcount++;
+       };
+       w.Filter<IntComponent,FloatComponent>(fboth);
+       assert(bothcount == (entities.size() - (iend - ibegin)));
    }
     
     return 0;
@@ -226,13 +245,986 @@ int Test_MoveBetweenWorlds(){
     return 0;
 }
 
+struct ChunkedInt : public ChunkedComponent{
+    int value = 0;
+};
+
+struct ChunkedFloat : public ChunkedComponent{
+    float value = 0;
+};
+
+int Test_Chunked(){
+    World w1, w2;
+    std::array<Entity, 40> entities;
+    for(int i = 0; i < entities.size(); i++){
+        entities[i] = w1.CreatePrototype<Entity>();
+        entities[i].EmplaceComponent<ChunkedInt>().value = i;
+        if (i % 2 == 0){
+            entities[i].EmplaceComponent<ChunkedFloat>().value = i;
+        }
+    }
+    
+    int icount = 0;
+    auto fic = [&](float, auto& ic){
+        icount++;
+    };
+    int bothcount = 0;
+    bool valuesMatch = true;
+    auto fboth = [&](float, auto& ic, auto& fc){
+        bothcount++;
+        valuesMatch = valuesMatch && ic.value == fc.value;
+    };
+    w1.Filter<ChunkedInt>(fic);
+    w1.Filter<ChunkedInt, ChunkedFloat>(fboth);
+    cout << "Spawning " << entities.size() << " chunked entities yields " << icount << " intcomponents and " << bothcount << " with both\n";
+    assert(icount == entities.size());
+    assert(bothcount == entities.size() / 2);
+    assert(valuesMatch);
+    
+    // changing an entity's signature must not disturb the others in its old archetype
+    entities[0].DestroyComponent<ChunkedFloat>();
+    assert(!entities[0].HasComponent<ChunkedFloat>());
+    assert(entities[0].GetComponent<ChunkedInt>().value == 0);
+    entities[2].Destroy();
+    
+    icount = 0;
+    bothcount = 0;
+    w1.Filter<ChunkedInt>(fic);
+    w1.Filter<ChunkedInt, ChunkedFloat>(fboth);
+    cout << "After removing a component and destroying an entity, filter yields " << icount << " intcomponents and " << bothcount << " with both\n";
+    assert(icount == entities.size() - 1);
+    assert(bothcount == entities.size() / 2 - 2);
+    assert(valuesMatch);
+    
+    entities[4].MoveTo(w2);
+    bothcount = 0;
+    w2.Filter<ChunkedInt, ChunkedFloat>(fboth);
+    assert(bothcount == 1);
+    assert(entities[4].GetComponent<ChunkedFloat>().value == 4);
+    assert(valuesMatch);
+    
+    return 0;
+}
+
+int Test_SpawnBatch(){
+    World w;
+    constexpr entity_t n_entities = 1000;
+    auto batch = w.SpawnBatch<IntComponent,FloatComponent>(n_entities, [](entity_t id, IntComponent& ic, FloatComponent& fc){
+        ic.value = id;
+        fc.value = 1;
+    });
+    
+    int count = 0;
+    auto fboth = [&](float, auto& ic, auto& fc){
+        count++;
+    };
+    w.Filter<IntComponent,FloatComponent>(fboth);
+    cout << "Spawning a batch of " << n_entities << " yields " << count << " entities\n";
+    assert(count == n_entities);
+    for(entity_t i = 0; i < n_entities; i++){
+        Entity e(batch.firstGlobal + i);
+        assert(e.GetWorld() == &w);
+        assert(e.GetComponent<IntComponent>().value == batch.firstGlobal + i);
+    }
+    
+    std::vector<Entity> toDestroy;
+    for(entity_t i = 0; i < n_entities; i += 2){
+        toDestroy.emplace_back(batch.firstGlobal + i);
+    }
+    w.DestroyEntities(toDestroy);
+    
+    count = 0;
+    w.Filter<IntComponent,FloatComponent>(fboth);
+    cout << "After destroying " << toDestroy.size() << " in a batch, " << count << " entities remain\n";
+    assert(count == n_entities - toDestroy.size());
+    assert(Entity(batch.firstGlobal + 1).GetComponent<IntComponent>().value == batch.firstGlobal + 1);
+    
+    return 0;
+}
+
+struct IntWriterSystem{
+    void operator()(float, IntComponent& ic) const{
+        ic.value++;
+    }
+};
+
+struct IntReaderSystem{
+    void operator()(float, const IntComponent& ic) const{}
+};
+
+struct BothReaderSystem{
+    void operator()(float, const IntComponent& ic, const FloatComponent& fc) const{}
+};
+
+struct FloatWriterSystem{
+    void operator()(float, const IntComponent& ic, FloatComponent& fc) const{
+        fc.value = ic.value;
+    }
+};
+
+// enough distinct types to need more than one word of each entity's component mask
+template<int N>
+struct LazyComponent{
+    int value;
+};
+
+template<int ... N>
+void FilterLazyComponents(World& w, std::integer_sequence<int, N...>){
+    auto count = [](float, auto&){};
+    (w.Filter<LazyComponent<N>>(count), ...);
+}
+
+int Test_ParallelSetCreation(){
+    World w;
+    auto e = w.CreatePrototype<MyPrototype>();
+    constexpr int n_types = 100;
+    
+    // the first Filter of a type creates its set, even when several tasks do so at once
+    tf::Executor executor(4);
+    tf::Taskflow flow;
+    for(int t = 0; t < 4; t++){
+        flow.emplace([&w]{
+            FilterLazyComponents(w, std::make_integer_sequence<int, n_types>());
+        });
+    }
+    executor.run(flow).wait();
+    
+    assert(w.GetAllComponentsOfType<LazyComponent<0>>().has_value());
+    assert(w.GetAllComponentsOfType<LazyComponent<n_types - 1>>().has_value());
+    
+    // the masks were widened without losing the bits already set
+    e.EmplaceComponent<LazyComponent<n_types - 1>>().value = 3;
+    assert(e.HasComponent<IntComponent>() && e.GetComponent<LazyComponent<n_types - 1>>().value == 3);
+    e.Destroy();
+    assert(w.GetAllComponentsOfType<IntComponent>().value()->DenseSize() == 0);
+    assert(w.GetAllComponentsOfType<LazyComponent<n_types - 1>>().value()->DenseSize() == 0);
+    return 0;
+}
+
+int Test_ParallelQueryGroups(){
+    // several rounds, because a race between the first Filters of each pair would only show some of the time
+    for(int round = 0; round < 20; round++){
+        World w;
+        constexpr int n = 100;
+        for(int i = 0; i < n; i++){
+            auto e = w.CreatePrototype<MyExtendedPrototype>();
+            if (i % 2 == 0){
+                e.EmplaceComponent<LazyComponent<0>>();
+            }
+        }
+        
+        // each pair's group is created by the first Filter over it, in tasks that run at the same time
+        std::atomic<int> bothCount = 0, lazyCount = 0;
+        tf::Executor executor(2);
+        tf::Taskflow flow;
+        flow.emplace([&]{
+            auto fn = [&](float, auto&, auto&){
+                bothCount++;
+            };
+            w.Filter<IntComponent, FloatComponent>(fn);
+        });
+        flow.emplace([&]{
+            auto fn = [&](float, auto&, auto&){
+                lazyCount++;
+            };
+            w.Filter<LazyComponent<0>, IntComponent>(fn);
+        });
+        executor.run(flow).wait();
+        assert(bothCount == n && lazyCount == n / 2);
+    }
+    
+    // registered groups are kept up to date like ones created by a Filter
+    World w;
+    w.RegisterQuery<IntComponent, FloatComponent>();
+    w.CreatePrototype<MyExtendedPrototype>();
+    int count = 0;
+    auto fn = [&](float, auto&, auto&){
+        count++;
+    };
+    w.Filter<FloatComponent, IntComponent>(fn);
+    assert(count == 1);
+    return 0;
+}
+
+int Test_SystemDependencies(){
+    static_assert(!SystemAccess<IntWriterSystem,IntComponent>::IsReadOnly<0>(), "non-const reference is a write");
+    static_assert(SystemAccess<IntReaderSystem,IntComponent>::IsReadOnly<0>(), "const reference is a read");
+    static_assert(SystemAccess<FloatWriterSystem,IntComponent,FloatComponent>::IsReadOnly<0>() && !SystemAccess<FloatWriterSystem,IntComponent,FloatComponent>::IsReadOnly<1>(), "access is per parameter");
+    
+    World w;
+    auto writer = w.EmplaceSystem<IntWriterSystem,IntComponent>();
+    auto reader = w.EmplaceSystem<IntReaderSystem,IntComponent>();
+    auto both = w.EmplaceSystem<BothReaderSystem,IntComponent,FloatComponent>();
+    auto floatWriter = w.EmplaceSystem<FloatWriterSystem,IntComponent,FloatComponent>();
+    
+    // each System also depends on its own range update task
+    cout << "Readers depend on " << reader.second.num_dependents() << " and " << both.second.num_dependents() << " tasks\n";
+    assert(writer.second.num_dependents() == 1);
+    assert(reader.second.num_dependents() == 2);        // after the writer only, not the other reader
+    assert(both.second.num_dependents() == 2);
+    assert(floatWriter.second.num_dependents() == 3);   // after the int writer and the float reader
+    
+    return 0;
+}
+
+static std::vector<int> commandLog;
+static std::vector<entity_t> commandCreated;
+
+struct LogA : public AutoCTTI{
+    int tag;
+    LogA(int tag) : tag(tag){
+        commandLog.push_back(tag);
+    }
+};
+
+struct LogB : public AutoCTTI{
+    int tag;
+    LogB(int tag) : tag(tag){
+        commandLog.push_back(tag);
+    }
+};
+
+struct LoggingPrototype : public Entity{
+    void Create(){
+        commandLog.push_back(0);
+        commandCreated.push_back(id);
+    }
+};
+
+int Test_CommandBuffer(){
+    World w, other;
+    std::array<Entity, 5> e;
+    for(auto& en : e){
+        en = w.CreatePrototype<MyPrototype>();
+    }
+    
+    auto& cmd = w.GetCommandBuffer();
+    cmd.EmplaceComponent<LogA>(e[0].id, 10);
+    cmd.EmplaceComponent<LogB>(e[0].id, 20);
+    cmd.EmplaceComponent<LogA>(e[1].id, 11);
+    cmd.EmplaceComponent<LogB>(e[1].id, 21);
+    cmd.Destroy(e[2].id);
+    cmd.EmplaceComponent<LogA>(e[2].id, 12);     // recorded after the destruction, but applied before it
+    cmd.DestroyComponent<IntComponent>(e[1].id);
+    cmd.EmplaceComponent<LogA>(e[3].id, 13);
+    cmd.EmplaceComponent<LogA>(e[4].id, 14);
+    cmd.CreatePrototype<LoggingPrototype>();
+    
+    // nothing is applied until playback
+    assert(commandLog.empty());
+    assert(!e[0].HasComponent<LogA>());
+    
+    // these happen after recording, so their commands must be skipped. The created entity may reuse e[3]'s id.
+    e[3].Destroy();
+    e[4].MoveTo(other);
+    
+    w.PlaybackCommands();
+    
+    cout << "Playback order:";
+    for(auto tag : commandLog){
+        cout << " " << tag;
+    }
+    cout << "\n";
+    
+    // creations first
+    assert(commandLog.size() == 6);
+    assert(commandLog[0] == 0);
+    
+    // then changes grouped by type, in recording order within a type
+    const std::vector<int> aFirst{0, 10, 11, 12, 20, 21}, bFirst{0, 20, 21, 10, 11, 12};
+    assert(commandLog == aFirst || commandLog == bFirst);
+    assert(e[0].GetComponent<LogA>().tag == 10 && e[0].GetComponent<LogB>().tag == 20);
+    assert(!e[1].HasComponent<IntComponent>());
+    
+    // then destructions
+    assert(!e[2].IsInWorld());
+    
+    // commands for destroyed and moved entities are skipped
+    assert(commandCreated.size() == 1);
+    Entity created(commandCreated[0]);
+    assert(created.GetWorld() == &w && !created.HasComponent<LogA>());
+    assert(e[4].GetWorld() == &other && !e[4].HasComponent<LogA>());
+    
+    // the buffers are empty afterwards
+    commandLog.clear();
+    w.PlaybackCommands();
+    assert(commandLog.empty());
+    
+    return 0;
+}
+
+int Test_ExecutionPolicy(){
+    tf::Executor executor(4);
+    const auto numWorkers = static_cast<pos_t>(executor.num_workers());
+    
+    // run a loop under a policy from inside a task, like a System does
+    auto run = [&](ExecutionState& state, pos_t n, const auto& body){
+        tf::Taskflow flow;
+        flow.emplace([&](tf::Subflow& sf){
+            state.ForEach(sf, n, numWorkers, body);
+        });
+        executor.run(flow).wait();
+    };
+    
+    // every index is visited exactly once, whatever the policy and range
+    for(auto policy : {ExecutionPolicy::Serial, ExecutionPolicy::StaticChunk, ExecutionPolicy::Guided, ExecutionPolicy::Adaptive}){
+        for(pos_t chunkSize : {1, 7, 100000}){
+            for(pos_t n : {0, 1, 10000}){
+                ExecutionState state;
+                state.policy = policy;
+                state.chunkSize = chunkSize;
+                std::vector<std::atomic<int>> visits(n);
+                // twice, so the adaptive policy also runs with a measured cost
+                for(int pass = 0; pass < 2; pass++){
+                    run(state, n, [&](pos_t i){
+                        visits[i]++;
+                    });
+                }
+                for(auto& v : visits){
+                    assert(v == 2);
+                }
+            }
+        }
+    }
+    
+    // the adaptive policy measures cost only once it has run something
+    ExecutionState adaptive;
+    run(adaptive, 0, [](pos_t){});
+    assert(adaptive.nsPerEntity == 0);
+    
+    // an expensive loop is measured as such, and split into chunks that take about the target time
+    std::vector<std::atomic<int>> visits(2000);
+    auto expensive = [&](pos_t i){
+        auto begin = e_clock_t::now();
+        while (e_clock_t::now() - begin < std::chrono::microseconds(5));
+        visits[i]++;
+    };
+    for(int pass = 0; pass < 3; pass++){
+        run(adaptive, static_cast<pos_t>(visits.size()), expensive);
+    }
+    cout << "Measured " << adaptive.nsPerEntity << " ns per entity\n";
+    assert(adaptive.nsPerEntity >= 5000);
+    for(auto& v : visits){
+        assert(v == 3);
+    }
+    
+    // a small, cheap range runs on the calling thread without spawning tasks
+    ExecutionState cheap;
+    std::vector<std::atomic<int>> small(numWorkers);     // no more than there are workers, so the first run is serial too
+    run(cheap, static_cast<pos_t>(small.size()), [&](pos_t i){ small[i]++; });
+    assert(cheap.nsPerEntity > 0 && cheap.nsPerEntity * small.size() < ExecutionState::adaptive_serial_threshold_ns);
+    std::thread::id caller;
+    std::atomic<int> otherThreads = 0;
+    tf::Taskflow flow;
+    flow.emplace([&](tf::Subflow& sf){
+        caller = std::this_thread::get_id();
+        cheap.ForEach(sf, static_cast<pos_t>(small.size()), numWorkers, [&](pos_t i){
+            small[i]++;
+            otherThreads += std::this_thread::get_id() != caller;
+        });
+    });
+    executor.run(flow).wait();
+    assert(otherThreads == 0);
+    for(auto& v : small){
+        assert(v == 2);
+    }
+    
+    return 0;
+}
+
+int Test_StaticBatches(){
+    StaticBatches<int> batches;
+    // every member must be where the reverse lookups say it is
+    auto check = [&]{
+        const auto& all = batches.GetBatches();
+        for(pos_t b = 0; b < all.size(); b++){
+            for(pos_t slot = 0; slot < all[b].members.size(); slot++){
+                assert(batches.BatchOf(all[b].members[slot]) == b);
+                assert(batches.SlotOf(all[b].members[slot]) == slot);
+            }
+        }
+    };
+    // every flattened index must map to one member and back
+    auto checkLayout = [&]{
+        const auto total = batches.Layout();
+        pos_t members = 0;
+        for(const auto& batch : batches.GetBatches()){
+            members += static_cast<pos_t>(batch.members.size());
+        }
+        assert(total == members);
+        for(pos_t i = 0; i < total; i++){
+            const auto [b, slot] = batches.Locate(i);
+            assert(slot < batches.GetBatches()[b].members.size());
+            assert(batches.FlatIndex(batches.GetBatches()[b].members[slot]) == i);
+        }
+        return total;
+    };
+    
+    for(entity_t i = 0; i < 10; i++){
+        batches.Add(i, i % 3);
+    }
+    check();
+    assert(batches.GetBatches().size() == 3);
+    assert(checkLayout() == 10);
+    
+    // the last member fills the removed one's slot
+    batches.Remove(3);
+    check();
+    assert(batches.BatchOf(3) == INVALID_INDEX);
+    assert((batches.GetBatches()[0].members == Vector<entity_t>{0, 9, 6}));
+    batches.Remove(6);     // the last member itself
+    check();
+    assert((batches.GetBatches()[0].members == Vector<entity_t>{0, 9}));
+    
+    // an emptied batch keeps its place, sharing its offset with the next one
+    for(entity_t i : {1, 4, 7}){
+        batches.Remove(i);
+    }
+    check();
+    assert(batches.GetBatches()[1].members.empty());
+    assert(checkLayout() == 5);
+    assert(batches.Offset(1) == batches.Offset(2));
+    
+    // and is reused by the next new key
+    batches.Add(20, 5);
+    batches.Add(21, 2);
+    check();
+    assert(batches.GetBatches().size() == 3);
+    assert(batches.BatchOf(20) == 1 && batches.GetBatches()[1].key == 5);
+    assert(batches.BatchOf(21) == 2);
+    assert(checkLayout() == 7);
+    
+    // moving to a different batch
+    batches.Remove(9);
+    batches.Add(9, 5);
+    check();
+    assert(batches.BatchOf(9) == 1 && batches.SlotOf(9) == 1);
+    assert(checkLayout() == 7);
+    
+    // the visible slots are numbered in order, without gaps
+    pos_t positions[] = {9, 9, 9, 9, 9, 9};
+    const uint8_t keep[] = {0, 1, 1, 0, 0, 1};
+    const auto kept = StaticBatches<int>::PackedPositions(keep, positions, 6);
+    assert(kept == 3);
+    assert(positions[1] == 0 && positions[2] == 1 && positions[5] == 2);
+    assert(positions[0] == 9 && positions[3] == 9 && positions[4] == 9);
+    const uint8_t none[] = {0, 0};
+    assert(StaticBatches<int>::PackedPositions(none, positions, 2) == 0);
+    
+    return 0;
+}
+
+int Test_RenderBucketMerge(){
+    auto tagged = [](float tag){
+        InstanceTransform t;
+        t.rows.fill(tag);
+        return t;
+    };
+    auto tags = [](const Vector<InstanceTransform>& items){
+        Vector<float> out;
+        for(const auto& item : items){
+            out.push_back(item.rows[0]);
+        }
+        return out;
+    };
+    
+    using map_t = UnorderedMap<int, FrameData::skinningEntry<InstanceTransform>>;
+    map_t target, workerA, workerB;
+    auto add = [&](map_t& bucket, int key, float tag){
+        auto& row = bucket[key];
+        row.AddItem(tagged(tag));
+        ozz::vector<InstanceTransform> palette{tagged(tag), tagged(tag + 0.5f)};
+        row.AddSkinningData(palette);
+    };
+    add(workerA, 1, 1);
+    add(workerA, 1, 2);
+    add(workerB, 1, 3);
+    add(workerB, 2, 4);
+    workerB[3];        // a row left over from an earlier frame
+    
+    FrameData::MergeBucket(workerA, target);
+    FrameData::MergeBucket(workerB, target);
+    
+    // rows are appended worker by worker, with the palettes in the same order as the instances
+    assert(target.size() == 2);
+    assert((tags(target[1].items) == Vector<float>{1, 2, 3}));
+    assert((tags(target[1].skinningdata) == Vector<float>{1, 1.5, 2, 2.5, 3, 3.5}));
+    assert((tags(target[2].items) == Vector<float>{4}));
+    assert((tags(target[2].skinningdata) == Vector<float>{4, 4.5}));
+    
+    // rows used this frame are kept empty for the next, unused ones are dropped
+    assert(workerA.size() == 1 && workerA[1].items.empty() && workerA[1].skinningdata.empty());
+    assert(workerB.size() == 2 && workerB.find(3) == workerB.end());
+    
+    // the next frame drops the rows that went unused
+    add(workerB, 1, 5);
+    map_t next;
+    FrameData::MergeBucket(workerB, next);
+    assert(workerB.size() == 1 && next.size() == 1);
+    assert((tags(next[1].items) == Vector<float>{5}));
+    
+    return 0;
+}
+
+int Test_ChangeTracking(){
+    World w;
+    std::vector<Entity> entities;
+    for(int i = 0; i < 10; i++){
+        entities.push_back(w.CreatePrototype<MyPrototype>());
+    }
+    
+    int count = 0;
+    auto fchanged = [&](float, IntComponent& ic){
+        count++;
+    };
+    uint64_t cursor = 0;
+    // newly added components count as changed
+    w.FilterChanged<IntComponent>(fchanged, cursor);
+    assert(count == entities.size());
+    
+    count = 0;
+    w.FilterChanged<IntComponent>(fchanged, cursor);
+    assert(count == 0);
+    
+    // reading does not count as a change
+    int sum = 0;
+    for(auto& e : entities){
+        sum += e.GetComponent<IntComponent>().value;
+    }
+    count = 0;
+    w.FilterChanged<IntComponent>(fchanged, cursor);
+    cout << "After reading " << entities.size() << " components, " << count << " are visited as changed\n";
+    assert(count == 0);
+    
+    entities[2].GetComponent<IntComponent>().value = 3;
+    entities[2].MarkChanged<IntComponent>();
+    entities[7].GetComponent<IntComponent>().value = 8;
+    entities[7].MarkChanged<IntComponent>();
+    entities[9].Destroy();
+    
+    // two consumers of the same type each see the changes, whichever scans first
+    uint64_t otherCursor = 0;
+    w.FilterChanged<IntComponent>(fchanged, otherCursor);     // catch up to now
+    entities[2].GetComponent<IntComponent>().value = 4;
+    entities[2].MarkChanged<IntComponent>();
+    
+    count = 0;
+    w.FilterChanged<IntComponent>(fchanged, cursor);
+    cout << "After modifying 2 components, " << count << " are visited as changed\n";
+    assert(count == 2);
+    count = 0;
+    w.FilterChanged<IntComponent>(fchanged, otherCursor);
+    assert(count == 1);
+    count = 0;
+    w.FilterChanged<IntComponent>(fchanged, cursor);
+    w.FilterChanged<IntComponent>(fchanged, otherCursor);
+    assert(count == 0);
+    
+    // a new cursor sees every component
+    uint64_t newCursor = 0;
+    count = 0;
+    w.FilterChanged<IntComponent>(fchanged, newCursor);
+    assert(count == entities.size() - 1);
+    
+    // Transforms mark themselves when moved, but not when read
+    auto a = w.CreatePrototype<GameObject>();
+    auto b = w.CreatePrototype<GameObject>();
+    w.UpdateTransforms();
+    uint64_t transformCursor = 0;
+    auto fmoved = [&](float, Transform& tr){
+        count++;
+    };
+    w.FilterChanged<Transform>(fmoved, transformCursor);
+    count = 0;
+    a.GetTransform().GetWorldPosition();
+    b.GetTransform().SetLocalPosition(vector3(1,2,3));
+    w.FilterChanged<Transform>(fmoved, transformCursor);
+    assert(count == 1);
+    
+    return 0;
+}
+
+int Test_TransformHierarchy(){
+    World w;
+    // create the child first, so that it comes before its parent in storage
+    auto child = w.CreatePrototype<GameObject>();
+    auto parent = w.CreatePrototype<GameObject>();
+    auto grandchild = w.CreatePrototype<GameObject>();
+    parent.GetTransform().AddChild(ComponentHandle<Transform>(child));
+    child.GetTransform().AddChild(ComponentHandle<Transform>(grandchild));
+    parent.GetTransform().SetLocalPosition(vector3(1,0,0));
+    child.GetTransform().SetLocalPosition(vector3(0,2,0));
+    grandchild.GetTransform().SetLocalPosition(vector3(0,0,3));
+    
+    w.UpdateTransforms();
+    
+    auto worldPos = [](Entity e){
+        return vector3(e.GetTransform().GetMatrix() * vector4(0,0,0,1));
+    };
+    cout << "Grandchild world position is " << worldPos(grandchild).x << "," << worldPos(grandchild).y << "," << worldPos(grandchild).z << "\n";
+    assert(worldPos(child) == vector3(1,2,0));
+    assert(worldPos(grandchild) == vector3(1,2,3));
+    
+    // moving the parent updates the cached matrices of everything below it, even when moved several times
+    parent.GetTransform().SetLocalPosition(vector3(5,0,0));
+    assert(grandchild.GetTransform().CalculateWorldMatrix() * vector4(0,0,0,1) == vector4(5,2,3,1));
+    parent.GetTransform().SetLocalPosition(vector3(-1,0,0));
+    w.UpdateTransforms();
+    assert(worldPos(grandchild) == vector3(-1,2,3));
+    assert(grandchild.GetTransform().CalculateWorldMatrix() == grandchild.GetTransform().GetMatrix());
+    
+    // reparenting is picked up without any Transforms being added or removed
+    parent.GetTransform().AddChild(ComponentHandle<Transform>(grandchild));
+    grandchild.GetTransform().SetLocalPosition(vector3(0,0,3));
+    w.UpdateTransforms();
+    assert(worldPos(grandchild) == vector3(-1,0,3));
+    
+    // world rotations are cached too, and match combining the parents' rotations
+    const auto turn = glm::angleAxis(decimalType(M_PI / 2), vector3_up);
+    parent.GetTransform().SetLocalRotation(turn);
+    grandchild.GetTransform().SetLocalRotation(turn);
+    const auto expected = turn * turn;
+    auto uncached = grandchild.GetTransform().GetWorldRotation();
+    w.UpdateTransforms();
+    auto cached = grandchild.GetTransform().GetWorldRotation();
+    assert(std::abs(glm::dot(cached, expected)) > 0.9999 && std::abs(glm::dot(uncached, expected)) > 0.9999);
+    assert(glm::distance(grandchild.GetTransform().GetWorldPosition(), vector3(-1,0,3)) > 1);  // now rotated around the parent
+    
+    // a directional light shines along its owner's world up, so tilting a parent tilts the light
+    auto sun = w.CreatePrototype<GameObject>();
+    sun.EmplaceComponent<DirectionalLight>();
+    assert(glm::distance(DirectionalLight::Direction(sun.GetTransform()), vector3_up) < 0.0001);
+    parent.GetTransform().AddChild(ComponentHandle<Transform>(sun));
+    parent.GetTransform().SetLocalRotation(glm::angleAxis(decimalType(M_PI / 2), vector3(0,0,1)));
+    w.UpdateTransforms();
+    assert(glm::distance(sun.GetTransform().Up(), vector3_up) < 0.0001);     // unchanged locally
+    assert(glm::distance(DirectionalLight::Direction(sun.GetTransform()), vector3(-1,0,0)) < 0.0001);
+    
+    return 0;
+}
+
+int Test_FrustumCulling(){
+    // looking down -Z from the origin
+    const auto proj = glm::perspective(decimalType(glm::radians(90.0)), decimalType(1), decimalType(0.1), decimalType(100));
+    const Frustum frustum(proj * glm::lookAt(vector3(0,0,0), vector3(0,0,-1), vector3(0,1,0)));
+    const vector3 unit(1,1,1);
+    assert(frustum.TestBox(vector3(0,0,-10), unit));
+    assert(!frustum.TestBox(vector3(0,0,10), unit));         // behind
+    assert(!frustum.TestBox(vector3(50,0,-10), unit));       // to the right
+    assert(!frustum.TestBox(vector3(0,0,-200), unit));       // past the far plane
+    assert(frustum.TestBox(vector3(10.5,0,-10), unit));      // straddling the right plane
+    
+    // lanes are reported in order, and unused ones are never set
+    const vector3 centers[] = {{0,0,10}, {0,0,-10}, {50,0,-10}};
+    const vector3 extents[] = {unit, unit, unit};
+    assert(frustum.TestBoxes(centers, extents, 3) == 0b010);
+    
+    // an empty frustum culls nothing
+    assert(Frustum().TestBoxes(centers, extents, 3) == 0b111);
+    
+    MeshAsset::Bounds bounds;
+    bounds.min[0] = bounds.min[1] = bounds.min[2] = -1;
+    bounds.max[0] = bounds.max[1] = bounds.max[2] = 1;
+    Vector<matrix4> transforms;
+    for(int i = 0; i < 10; i++){
+        transforms.push_back(glm::translate(matrix4(1), vector3(0, 0, i % 2 == 0 ? -10 : 10)));
+    }
+    const auto kept = frustum.CullTransforms(transforms.data(), transforms.size(), bounds, transforms.data());
+    cout << "Kept " << kept << " of " << transforms.size() << " transforms\n";
+    assert(kept == 5);
+    assert(transforms[4][3].z == -10);
+    
+    return 0;
+}
+
+int Test_LightCulling(){
+    // looking down -Z from the origin, so the view is as wide as it is far
+    const auto proj = glm::perspective(decimalType(glm::radians(90.0)), decimalType(1), decimalType(0.1), decimalType(100));
+    CullingVolumes volumes;
+    volumes.camera = Frustum(proj * glm::lookAt(vector3(0,0,0), vector3(0,0,-1), vector3(0,1,0)));
+    auto at = [](decimalType x, decimalType y, decimalType z){
+        return glm::translate(matrix4(1), vector3(x, y, z));
+    };
+    
+    PointLight point;
+    point.Intensity = 2;    // a volume 4 units in radius
+    auto pointVisible = [&](const matrix4& transform){
+        return volumes.LightVisible(point, point.CalculateMatrix(transform));
+    };
+    assert(pointVisible(at(0,0,-20)));
+    assert(!pointVisible(at(0,0,20)));        // behind
+    assert(!pointVisible(at(50,0,-20)));      // to the right
+    assert(!pointVisible(at(0,0,-200)));      // past the far plane
+    assert(pointVisible(at(22,0,-20)));       // the center is outside, but the volume reaches in
+    
+    SpotLight spot;
+    spot.Intensity = 3;     // a cone 6 units long
+    assert(volumes.LightVisible(spot, spot.CalculateMatrix(at(0,0,-30))));
+    assert(!volumes.LightVisible(spot, spot.CalculateMatrix(at(0,0,30))));
+    
+    // without a camera, no lights are culled
+    CullingVolumes noCamera;
+    assert(noCamera.LightVisible(point, point.CalculateMatrix(at(0,0,20))));
+    
+    // only lights that cast shadows add volumes
+    volumes.AddShadowVolume(point, at(0,0,20));
+    assert(volumes.NumShadowVolumes() == 0);
+    point.SetCastsShadows(true);
+    spot.SetCastsShadows(true);
+    volumes.AddShadowVolume(point, at(0,0,20));
+    volumes.AddShadowVolume(spot, at(0,0,-30));
+    assert(volumes.NumShadowVolumes() == 2);
+    
+    // casters out of view are kept when they are inside a shadow-casting light's volume
+    const vector3 unit(1,1,1);
+    const vector3 centers[] = {{0,0,18}, {0,0,40}, {0,0,-10}, {0,0,-28}};
+    const vector3 extents[] = {unit, unit, unit, unit};
+    uint32_t castersFound = 0;
+    const auto visible = volumes.TestBoxes(centers, extents, 4, castersFound);
+    cout << "Light culling kept boxes " << visible << " with " << castersFound << " casters\n";
+    assert(visible == 0b1101);
+    assert(castersFound == 2);
+    
+    // a directional light's shadow map covers an area around the origin, behind the camera too
+    DirectionalLight sun;
+    sun.SetCastsShadows(true);
+    volumes.ClearShadowVolumes();
+    assert(volumes.NumShadowVolumes() == 0);
+    volumes.AddShadowVolume(sun, glm::normalize(vector3(0,-1,-1)));
+    castersFound = 0;
+    const vector3 behind[] = {{0,0,10}, {0,0,200}};
+    assert(volumes.TestBoxes(behind, extents, 2, castersFound) == 0b01);
+    assert(castersFound == 1);
+    
+    return 0;
+}
+
+int Test_BVH(){
+    // a 20x20 grid of unit boxes on the XZ plane
+    Vector<AABB> boxes;
+    for(int x = 0; x < 20; x++){
+        for(int z = 0; z < 20; z++){
+            boxes.push_back(AABB::FromCenterExtent(vector3(x * 3, 0, -z * 3), vector3(1,1,1)));
+        }
+    }
+    BVH bvh;
+    bvh.Build(boxes.data(), boxes.size());
+    
+    // every query gives the same answer as testing each box
+    auto check = [&](){
+        const AABB region{vector3(5,-1,-20), vector3(20,1,-5)};
+        size_t found = 0, expected = 0;
+        bvh.QueryBox(region, [&](uint32_t item){
+            found++;
+            assert(region.Intersects(boxes[item]));
+        });
+        for(const auto& box : boxes){
+            expected += region.Intersects(box);
+        }
+        assert(found == expected);
+        
+        const auto proj = glm::perspective(decimalType(glm::radians(60.0)), decimalType(1), decimalType(0.1), decimalType(30));
+        const Frustum frustum(proj * glm::lookAt(vector3(0,0,5), vector3(0,0,-1), vector3(0,1,0)));
+        found = 0, expected = 0;
+        bvh.QueryFrustum(frustum, [&](uint32_t item){
+            found++;
+        });
+        for(const auto& box : boxes){
+            expected += frustum.TestBox(box.Center(), box.Extent());
+        }
+        assert(found == expected && expected > 0 && expected < boxes.size());
+        return found;
+    };
+    auto visible = check();
+    cout << visible << " of " << boxes.size() << " boxes are visible\n";
+    
+    // moving a box into view is picked up by refitting
+    boxes[boxes.size() - 1] = AABB::FromCenterExtent(vector3(0,0,-5), vector3(1,1,1));
+    bvh.Update(static_cast<uint32_t>(boxes.size() - 1), boxes.back());
+    bvh.Refit();
+    assert(check() == visible + 1);
+    
+    // a ray down -Z from the origin passes through the boxes in the first column, and the one that moved
+    size_t hits = 0;
+    bvh.QueryRay(vector3(0,0,2), vector3(0,0,-1), 1000, [&](uint32_t item, decimalType distance){
+        hits++;
+        assert(distance >= 0);
+    });
+    assert(hits == 20 + 1);
+    
+    return 0;
+}
+
+int Test_ClusterAssignment(){
+    LightClusters clusters;
+    const auto proj = glm::perspective(decimalType(glm::radians(60.0)), decimalType(16.0 / 9), decimalType(0.1), decimalType(100));
+    clusters.SetView(proj, 0.1, 100);
+    
+    // view-space spheres, with the camera looking down -Z. The last one is behind the camera.
+    const vector4 lights[] = {{0,0,-5,1}, {3,1,-20,4}, {-2,-1,-50,10}, {0,0,10,1}};
+    constexpr auto n_lights = sizeof(lights) / sizeof(lights[0]);
+    clusters.BeginAssign(lights, n_lights);
+    for(uint32_t z = 0; z < LightClusters::gridZ; z++){
+        clusters.AssignSlice(z);
+    }
+    
+    auto clusterHas = [&](uint32_t cluster, uint32_t light){
+        const auto first = clusters.GetLights(cluster);
+        return std::find(first, first + clusters.GetCount(cluster), light) != first + clusters.GetCount(cluster);
+    };
+    
+    // every point inside a light's volume finds that light in its cluster
+    size_t checked = 0;
+    for(uint32_t i = 0; i < n_lights; i++){
+        const vector3 center(lights[i]);
+        const auto step = lights[i].w / 4;
+        for(int x = -3; x <= 3; x++){
+            for(int y = -3; y <= 3; y++){
+                for(int z = -3; z <= 3; z++){
+                    const auto p = center + vector3(x, y, z) * step;
+                    if (glm::distance(p, center) >= lights[i].w * decimalType(0.99)){
+                        continue;
+                    }
+                    const auto cluster = clusters.ClusterOf(p);
+                    if (cluster != INVALID_INDEX){
+                        assert(clusterHas(cluster, i));
+                        checked++;
+                    }
+                }
+            }
+        }
+    }
+    cout << "Checked " << checked << " points inside lights\n";
+    assert(checked > 0);
+    
+    // a light is only in clusters its volume overlaps
+    uint32_t clustersWithBehind = 0, clustersWithNear = 0;
+    for(uint32_t cluster = 0; cluster < LightClusters::numClusters; cluster++){
+        clustersWithBehind += clusterHas(cluster, 3);
+        clustersWithNear += clusterHas(cluster, 0);
+    }
+    assert(clustersWithBehind == 0);
+    assert(clustersWithNear > 0 && clustersWithNear < LightClusters::numClusters / 4);
+    
+    // the packed buffer has each cluster's lights at its offset
+    const auto& packed = clusters.Pack();
+    for(uint32_t cluster = 0; cluster < LightClusters::numClusters; cluster++){
+        const auto offset = packed[cluster * 2], count = packed[cluster * 2 + 1];
+        assert(count == clusters.GetCount(cluster));
+        assert(std::equal(packed.begin() + offset, packed.begin() + offset + count, clusters.GetLights(cluster)));
+    }
+    
+    return 0;
+}
+
+int Test_InstanceArena(){
+    // the Noop renderer still hands out transient memory, so this runs without a window or GPU
+    bgfx::Init settings;
+    settings.type = bgfx::RendererType::Noop;
+    if (!bgfx::init(settings)){
+        return -1;
+    }
+    FrameData fd;
+    auto& arena = fd.instanceArena;
+    
+    // nothing is reserved before the first frame, so everything overflows into items
+    arena.Reserve(arena.NextReservation());
+    assert(arena.capacity == 0);
+    assert(arena.Allocate(10) == INVALID_INDEX);
+    assert(arena.Allocate(6) == INVALID_INDEX);
+    bgfx::frame();
+    
+    // the next frame reserves what was asked for, with room to spare
+    arena.Reserve(arena.NextReservation());
+    assert(arena.capacity == 20);
+    const auto a = arena.Allocate(10), b = arena.Allocate(6);
+    assert(a == 0 && b == 10);
+    assert(arena.Allocate(5) == INVALID_INDEX);
+    
+    // rows drawn from the arena read back what extraction wrote
+    matrix4 m(1);
+    m[3] = vector4(1, 2, 3, 1);
+    for(uint32_t i = 0; i < 6; i++){
+        arena.Get(b)[i] = InstanceTransform(m);
+    }
+    auto& row = fd.opaques[{nullptr, nullptr}];
+    row.arenaFirst = b;
+    row.arenaCount = 6;
+    row.AddItem(InstanceTransform(m));
+    assert(row.size() == 7);
+    const auto data = reinterpret_cast<const float*>(arena.idb.data) + b * 12;
+    assert(data[3] == 1 && data[7] == 2 && data[11] == 3);
+    fd.Clear();
+    assert(row.size() == 0 && row.arenaFirst == INVALID_INDEX);
+    
+    bgfx::frame();
+    bgfx::shutdown();
+    return 0;
+}
+
+int Test_RadixSort(){
+    // enough keys that the executor splits each pass, with low bytes that vary and high bytes that do not
+    constexpr size_t n = 100000;
+    std::mt19937_64 rng(42);
+    Vector<uint64_t> keys(n);
+    Vector<uint32_t> values(n);
+    for(size_t i = 0; i < n; i++){
+        keys[i] = DrawSortKey::Make(0, rng() % 8, rng() % 100, rng() % 1000, rng() % 256);
+        values[i] = static_cast<uint32_t>(i);
+    }
+    Vector<std::pair<uint64_t, uint32_t>> expected(n);
+    for(size_t i = 0; i < n; i++){
+        expected[i] = {keys[i], values[i]};
+    }
+    std::stable_sort(expected.begin(), expected.end(), [](const auto& a, const auto& b){
+        return a.first < b.first;
+    });
+    
+    auto check = [&](const Vector<uint64_t>& sortedKeys, const Vector<uint32_t>& sortedValues){
+        for(size_t i = 0; i < n; i++){
+            assert(sortedKeys[i] == expected[i].first && sortedValues[i] == expected[i].second);
+        }
+    };
+    auto serialKeys = keys;
+    auto serialValues = values;
+    RadixSort(serialKeys.data(), serialValues.data(), n);
+    check(serialKeys, serialValues);
+    
+    tf::Executor executor(4);
+    RadixSort(keys.data(), values.data(), n, &executor);
+    check(keys, values);
+    
+    // the fields come back out of the key they were packed into
+    const auto key = DrawSortKey::Make(3, 500, 7, 65535, 200);
+    assert(DrawSortKey::Program(key) == 500 && DrawSortKey::Material(key) == 7 && DrawSortKey::Mesh(key) == 65535);
+    assert(DrawSortKey::DepthBucket(0) == 0 && DrawSortKey::DepthBucket(1e30f) == 255);
+    return 0;
+}
+
 int main(int argc, char** argv) {
     const unordered_map<std::string_view, std::function<int(void)>> tests{
 		{"CTTI",&Test_CTTI},
         {"Test_UUID",&Test_UUID},
         {"Test_AddDel",&Test_AddDel},
         {"Test_SpawnDestroy",&Test_SpawnDestroy},
-        {"Test_MoveBetweenWorlds",&Test_MoveBetweenWorlds}
+        {"Test_MoveBetweenWorlds",&Test_MoveBetweenWorlds},
+        {"Test_Chunked",&Test_Chunked},
+        {"Test_SpawnBatch",&Test_SpawnBatch},
+        {"Test_ParallelSetCreation",&Test_ParallelSetCreation},
+        {"Test_ParallelQueryGroups",&Test_ParallelQueryGroups},
+        {"Test_SystemDependencies",&Test_SystemDependencies},
+        {"Test_CommandBuffer",&Test_CommandBuffer},
+        {"Test_ExecutionPolicy",&Test_ExecutionPolicy},
+        {"Test_StaticBatches",&Test_StaticBatches},
+        {"Test_RenderBucketMerge",&Test_RenderBucketMerge},
+        {"Test_ChangeTracking",&Test_ChangeTracking},
+        {"Test_TransformHierarchy",&Test_TransformHierarchy},
+        {"Test_FrustumCulling",&Test_FrustumCulling},
+        {"Test_LightCulling",&Test_LightCulling},
+        {"Test_BVH",&Test_BVH},
+        {"Test_ClusterAssignment",&Test_ClusterAssignment},
+        {"Test_InstanceArena",&Test_InstanceArena},
+        {"Test_RadixSort",&Test_RadixSort}
     };
 	    
 	if (argc < 2){
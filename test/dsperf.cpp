@@ -5,7 +5,14 @@
 #include <typeinfo>
 #include <RavEngine/AnimatorComponent.hpp>
 #include <RavEngine/unordered_vector.hpp>
+#include <RavEngine/World.hpp>
+#include <RavEngine/ArchetypeStorage.hpp>
+#include <RavEngine/TransformHierarchy.hpp>
 #include <boost/container/vector.hpp>
+#include <random>
+#include <numeric>
+#include <cstring>
+#include <bgfx/bgfx.h>
 
 using namespace RavEngine;
 using namespace std;
@@ -53,6 +60,330 @@ static inline void do_test(const T& ds, const is_fn& insert_func, const es_fn& e
     
 }
 
+struct BenchPosition{
+	float x, y, z;
+};
+struct BenchVelocity{
+	float x, y, z;
+};
+struct BenchMass{
+	float value;
+};
+
+// integrate 200K entities the way a 3-component System would, once through SparseSets and once through archetype chunks
+static inline void storage_test(){
+	constexpr entity_t n_entities = 200'000;
+	constexpr auto iter_count = 100;
+	constexpr float scale = 0.01f;
+	
+	// entities gain components at different times, so each set's dense order differs
+	std::vector<entity_t> order(n_entities);
+	std::iota(order.begin(), order.end(), 0);
+	std::mt19937 gen(42);
+	
+	World::SparseSet<BenchPosition> positions;
+	World::SparseSet<BenchVelocity> velocities;
+	World::SparseSet<BenchMass> masses;
+	ArchetypeStorage chunks;
+	for(const auto id : order){
+		positions.Emplace(id, BenchPosition{0,0,0});
+		chunks.Emplace<BenchPosition>(id, BenchPosition{0,0,0});
+	}
+	std::shuffle(order.begin(), order.end(), gen);
+	for(const auto id : order){
+		velocities.Emplace(id, BenchVelocity{1,2,3});
+		chunks.Emplace<BenchVelocity>(id, BenchVelocity{1,2,3});
+	}
+	std::shuffle(order.begin(), order.end(), gen);
+	for(const auto id : order){
+		masses.Emplace(id, BenchMass{2});
+		chunks.Emplace<BenchMass>(id, BenchMass{2});
+	}
+	
+	auto integrate = [](BenchPosition& pos, const BenchVelocity& vel, const BenchMass& mass){
+		pos.x += vel.x * scale / mass.value;
+		pos.y += vel.y * scale / mass.value;
+		pos.z += vel.z * scale / mass.value;
+	};
+	
+	cout << "\nSparseSet 3-component iteration\n";
+	auto dur = time([&]{
+		for(int i = 0; i < iter_count; i++){
+			for(entity_t d = 0; d < positions.DenseSize(); d++){
+				auto owner = positions.GetOwner(d);
+				if (velocities.HasComponent(owner) && masses.HasComponent(owner)){
+					integrate(positions.Get(d), velocities.GetComponent(owner), masses.GetComponent(owner));
+				}
+			}
+		}
+	});
+	cout << StrFormat("Time to iterate {} entities {} times: {} µs (x = {})\n", n_entities, iter_count, dur.count(), positions.GetFirst().x);
+	
+	cout << "\nArchetypeStorage 3-component iteration\n";
+	dur = time([&]{
+		for(int i = 0; i < iter_count; i++){
+			chunks.ForEach<BenchPosition, BenchVelocity, BenchMass>(integrate);
+		}
+	});
+	cout << StrFormat("Time to iterate {} entities {} times: {} µs (x = {})\n", n_entities, iter_count, dur.count(), chunks.GetFirst<BenchPosition>().x);
+}
+
+template<int N>
+struct LookupBenchType{
+	int value;
+};
+
+// find the storage for a component type the way World used to (hashing CTTI into a locked map), and by ComponentTypeIndex
+template<int ... N>
+static inline void lookup_test(std::integer_sequence<int, N...>){
+	constexpr auto n_lookups = 10'000'000;
+	
+	locked_node_hashmap<ctti_t, uintptr_t, SpinLock> map;
+	Vector<uintptr_t> table;
+	(map.try_emplace(CTTI<LookupBenchType<N>>(), N), ...);
+	table.resize(std::max({ComponentTypeIndex<LookupBenchType<N>>()...}) + 1);
+	((table[ComponentTypeIndex<LookupBenchType<N>>()] = N), ...);
+	
+	cout << StrFormat("\nComponent lookup with {} registered types\n", sizeof ... (N));
+	uintptr_t sum = 0;
+	auto dur = time([&]{
+		for(int i = 0; i < n_lookups; i++){
+			sum += map.at(CTTI<LookupBenchType<0>>()) + map.at(CTTI<LookupBenchType<41>>()) + map.at(CTTI<LookupBenchType<79>>());
+		}
+	});
+	cout << StrFormat("Time for {} CTTI hashmap lookups: {} µs (sum = {})\n", n_lookups * 3, dur.count(), sum);
+	
+	sum = 0;
+	dur = time([&]{
+		for(int i = 0; i < n_lookups; i++){
+			sum += table[ComponentTypeIndex<LookupBenchType<0>>()] + table[ComponentTypeIndex<LookupBenchType<41>>()] + table[ComponentTypeIndex<LookupBenchType<79>>()];
+		}
+	});
+	cout << StrFormat("Time for {} type index lookups: {} µs (sum = {})\n", n_lookups * 3, dur.count(), sum);
+}
+
+// sparse index memory for component types that are each on a few entities scattered across a large world
+template<int ... N>
+static inline void sparse_memory_test(std::integer_sequence<int, N...>){
+	constexpr entity_t n_entities = 1'000'000;
+	constexpr entity_t per_type = 100;
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<entity_t> dist(0, n_entities - 1);
+	
+	size_t paged = 0, flat = 0;
+	auto fill = [&](auto&& set){
+		entity_t max_id = 0;
+		for(entity_t i = 0; i < per_type; i++){
+			auto id = dist(gen);
+			if (!set.HasComponent(id)){
+				set.Emplace(id);
+				max_id = std::max(max_id, id);
+			}
+		}
+		paged += set.SparseMemoryUsage();
+		flat += (max_id + 1) * sizeof(entity_t);    // a flat array must be sized to the largest id
+	};
+	(fill(World::SparseSet<LookupBenchType<N>>()), ...);
+	
+	cout << StrFormat("\nSparse index memory for {} types on {} of {} entities each\n", sizeof ... (N), per_type, n_entities);
+	cout << StrFormat("Flat: {} KB, paged: {} KB, saved {} KB\n", flat / 1024, paged / 1024, (flat - paged) / 1024);
+	
+	// lookup cost of a fully populated set
+	World::SparseSet<LookupBenchType<0>> set;
+	Vector<entity_t> flatArray(n_entities);
+	for(entity_t i = 0; i < n_entities; i++){
+		set.Emplace(i);
+		flatArray[i] = i;
+	}
+	uint64_t sum = 0;
+	auto dur = time([&]{
+		for(entity_t i = 0; i < n_entities; i++){
+			sum += flatArray[i] != INVALID_ENTITY;
+		}
+	});
+	cout << StrFormat("Time for {} flat lookups: {} µs (sum = {})\n", n_entities, dur.count(), sum);
+	sum = 0;
+	dur = time([&]{
+		for(entity_t i = 0; i < n_entities; i++){
+			sum += set.HasComponent(i);
+		}
+	});
+	cout << StrFormat("Time for {} paged lookups: {} µs (sum = {})\n", n_entities, dur.count(), sum);
+}
+
+// root transforms to matrices, SIMD batches vs one at a time with glm
+static inline void transform_kernel_test(){
+	constexpr size_t n_transforms = 100'000;
+	constexpr int iter_count = 100;
+	std::mt19937 gen(42);
+	std::uniform_real_distribution<float> dist(-10, 10);
+	TransformSoA soa;
+	soa.resize(n_transforms);
+	for(size_t i = 0; i < n_transforms; i++){
+		auto rotation = glm::normalize(quaternion(dist(gen), dist(gen), dist(gen), dist(gen)));
+		soa.Set(i, vector3(dist(gen), dist(gen), dist(gen)), rotation, vector3(dist(gen), dist(gen), dist(gen)));
+	}
+	Vector<matrix4> matrices(n_transforms);
+	
+	cout << StrFormat("\nLocal matrices for {} transforms\n", n_transforms);
+	auto dur = time([&]{
+		for(int i = 0; i < iter_count; i++){
+			ComputeLocalMatricesScalar(soa, 0, n_transforms, matrices.data());
+		}
+	});
+	cout << StrFormat("Scalar glm, {} times: {} µs (m = {})\n", iter_count, dur.count(), matrices.back()[3][0]);
+	dur = time([&]{
+		for(int i = 0; i < iter_count; i++){
+			ComputeLocalMatrices(soa, 0, n_transforms, matrices.data());
+		}
+	});
+	cout << StrFormat("SIMD x{}, {} times: {} µs (m = {})\n", TransformSoA::simd_width, iter_count, dur.count(), matrices.back()[3][0]);
+}
+
+// uploading a frame of instance transforms, full matrices copied element by element vs the compact rows copied at once
+static inline void instance_upload_test(){
+	constexpr size_t n_instances = 100'000;
+	constexpr int iter_count = 100;
+	Vector<matrix4> matrices(n_instances);
+	for(size_t i = 0; i < n_instances; i++){
+		matrices[i] = glm::translate(matrix4(1), vector3(i, i * 2, i * 3));
+	}
+	Vector<InstanceTransform> compact(matrices.begin(), matrices.end());
+	Vector<uint8_t> buffer(n_instances * sizeof(matrix4));
+	
+	cout << StrFormat("\nInstance upload for {} instances\n", n_instances);
+	auto dur = time([&]{
+		for(int i = 0; i < iter_count; i++){
+			size_t offset = 0;
+			for(const auto& m : matrices){
+				auto src = glm::value_ptr(m);
+				auto dest = reinterpret_cast<float*>(buffer.data() + offset);
+				for(int f = 0; f < 16; f++){
+					dest[f] = src[f];
+				}
+				offset += sizeof(matrix4);
+			}
+		}
+	});
+	cout << StrFormat("matrix4, {} bytes per frame, {} times: {} µs\n", n_instances * sizeof(matrix4), iter_count, dur.count());
+	dur = time([&]{
+		for(int i = 0; i < iter_count; i++){
+			std::memcpy(buffer.data(), compact.data(), n_instances * sizeof(InstanceTransform));
+		}
+	});
+	cout << StrFormat("InstanceTransform, {} bytes per frame, {} times: {} µs (m = {})\n", n_instances * sizeof(InstanceTransform), iter_count, dur.count(), reinterpret_cast<float*>(buffer.data())[7]);
+}
+
+// gathering and uploading the skinning palettes of a crowd, as nested 4x4 matrices repacked a float at a time vs
+// palettes kept in upload layout and appended to one buffer
+static inline void pose_upload_test(){
+	constexpr size_t n_characters = 1000, n_joints = 64;
+	constexpr int iter_count = 100;
+	Vector<ozz::vector<matrix4>> matrixPalettes(n_characters, ozz::vector<matrix4>(n_joints));
+	Vector<ozz::vector<InstanceTransform>> compactPalettes(n_characters, ozz::vector<InstanceTransform>(n_joints));
+	for(size_t c = 0; c < n_characters; c++){
+		for(size_t j = 0; j < n_joints; j++){
+			matrixPalettes[c][j] = glm::translate(matrix4(1), vector3(c, j, 1));
+			compactPalettes[c][j] = InstanceTransform(matrixPalettes[c][j]);
+		}
+	}
+	Vector<uint8_t> buffer(n_characters * n_joints * sizeof(matrix4));
+	
+	cout << StrFormat("\nPose upload for {} characters with {} joints\n", n_characters, n_joints);
+	// frame data is cleared rather than freed between frames, so both keep their storage across iterations
+	ozz::vector<ozz::vector<matrix4>> skinningdata;
+	auto dur = time([&]{
+		for(int i = 0; i < iter_count; i++){
+			skinningdata.clear();
+			for(const auto& palette : matrixPalettes){
+				skinningdata.push_back(palette);
+			}
+			auto dest = reinterpret_cast<float*>(buffer.data());
+			for(const auto& palette : skinningdata){
+				for(const auto& m : palette){
+					auto ptr = glm::value_ptr(m);
+					for(int f = 0; f < 16; f++){
+						*dest++ = static_cast<float>(ptr[f]);
+					}
+				}
+			}
+		}
+	});
+	cout << StrFormat("matrix4 palettes, {} times: {} µs\n", iter_count, dur.count());
+	FrameData::skinningEntry<InstanceTransform> entry;
+	dur = time([&]{
+		for(int i = 0; i < iter_count; i++){
+			entry.clear();
+			for(const auto& palette : compactPalettes){
+				entry.AddSkinningData(palette);
+			}
+			std::memcpy(buffer.data(), entry.skinningdata.data(), entry.skinningdata.size() * sizeof(InstanceTransform));
+		}
+	});
+	cout << StrFormat("InstanceTransform palettes, {} times: {} µs (m = {})\n", iter_count, dur.count(), reinterpret_cast<float*>(buffer.data())[7]);
+}
+
+// recording a frame of synthetic draws from one thread vs one encoder per worker. This uses the Noop renderer, so it
+// measures only the cost of submission and runs without a window or GPU.
+static inline void encoder_submit_test(){
+	constexpr uint32_t n_draws = 60'000;	// just under bgfx's default limit per frame
+	constexpr int iter_count = 20;
+	bgfx::Init settings;
+	settings.type = bgfx::RendererType::Noop;
+	settings.limits.maxEncoders = 16;
+	if (!bgfx::init(settings)){
+		cout << "\nEncoder submission skipped, could not start bgfx\n";
+		return;
+	}
+	bgfx::VertexLayout layout;
+	layout.begin().add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float).end();
+	const float vertices[9]{0};
+	const auto vertexBuffer = bgfx::createVertexBuffer(bgfx::copy(vertices, sizeof(vertices)), layout);
+	const auto uniform = bgfx::createUniform("u_bench", bgfx::UniformType::Vec4);
+	
+	// the state a geometry row sets up before it draws, minus the program, which Noop cannot load
+	auto record = [&](bgfx::Encoder* encoder, uint32_t begin, uint32_t end){
+		for(uint32_t i = begin; i < end; i++){
+			const float values[4]{static_cast<float>(i), 0, 0, 0};
+			encoder->setUniform(uniform, values);
+			encoder->setVertexBuffer(0, vertexBuffer);
+			encoder->setState(BGFX_STATE_DEFAULT);
+			encoder->submit(0, BGFX_INVALID_HANDLE);
+		}
+	};
+	
+	cout << StrFormat("\nEncoder submission for {} draws\n", n_draws);
+	auto dur = time([&]{
+		for(int i = 0; i < iter_count; i++){
+			auto encoder = bgfx::begin();
+			record(encoder, 0, n_draws);
+			bgfx::end(encoder);
+			bgfx::frame();
+		}
+	});
+	cout << StrFormat("1 encoder, {} frames: {} µs\n", iter_count, dur.count());
+	
+	tf::Executor executor;
+	const uint32_t n_encoders = std::min<uint32_t>(static_cast<uint32_t>(executor.num_workers()), bgfx::getCaps()->limits.maxEncoders - 1);
+	dur = time([&]{
+		for(int i = 0; i < iter_count; i++){
+			tf::Taskflow flow;
+			flow.for_each_index(uint32_t(0), n_encoders, uint32_t(1), [&](uint32_t task){
+				auto encoder = bgfx::begin(true);
+				const auto perTask = (n_draws + n_encoders - 1) / n_encoders;
+				record(encoder, task * perTask, std::min(n_draws, (task + 1) * perTask));
+				bgfx::end(encoder);
+			});
+			executor.run(flow).wait();
+			bgfx::frame();
+		}
+	});
+	cout << StrFormat("{} encoders, {} frames: {} µs\n", n_encoders, iter_count, dur.count());
+	
+	bgfx::destroy(uniform);
+	bgfx::destroy(vertexBuffer);
+	bgfx::shutdown();
+}
 
 int main(int argc, const char** argv){
 	
@@ -182,5 +513,13 @@ int main(int argc, const char** argv){
 		});
 	}
 	
+	storage_test();
+	lookup_test(std::make_integer_sequence<int, 80>());
+	sparse_memory_test(std::make_integer_sequence<int, 80>());
+	transform_kernel_test();
+	instance_upload_test();
+	pose_upload_test();
+	encoder_submit_test();
+	
 	return 0;
 }